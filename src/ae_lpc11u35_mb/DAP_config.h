@@ -69,7 +69,20 @@
 /// This configuration settings is used to optimize the communication performance with the
 /// debugger and depends on the USB peripheral. For devices with limited RAM or USB buffer the
 /// setting can be reduced (valid range is 1 .. 255).
-#define DAP_PACKET_COUNT        8U              ///< Specifies number of packets buffered.
+#define DAP_PACKET_COUNT        16U              ///< Specifies number of packets buffered.
+
+/// Size of the request and the response packet arena, each.
+/// Packets are stored by their actual size, so small requests and responses take less than
+/// \ref DAP_PACKET_SIZE. It must hold at least one packet of \ref DAP_PACKET_SIZE.
+#define DAP_PACKET_ARENA_SIZE   512U            ///< Packet arena size in bytes per direction.
+
+/// Maximum number of requests executed per main loop pass.
+/// Received requests are executed back to back up to this count before USB is serviced again.
+#define DAP_EXECUTE_BUDGET      8U              ///< Requests per main loop pass (1 .. DAP_PACKET_COUNT).
+
+/// Execute DAP commands on the second core.
+/// USB and the CDC bridge keep being serviced on core0 while a long command runs.
+#define DAP_DUAL_CORE           0               ///< Dual core: 1 = core1 executes commands, 0 = single superloop.
 
 /// Indicate that UART Serial Wire Output (SWO) trace is available.
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
@@ -81,6 +94,9 @@
 /// Maximum SWO UART Baudrate.
 #define SWO_UART_MAX_BAUDRATE   10000000U       ///< SWO UART Maximum Baudrate in Hz.
 
+/// Capture UART SWO by DMA straight into the trace buffer.
+#define SWO_UART_DMA            0               ///< SWO UART DMA: 1 = DMA ring, 0 = polled by the main loop.
+
 /// Indicate that Manchester Serial Wire Output (SWO) trace is available.
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
 #define SWO_MANCHESTER          0               ///< SWO Manchester:  1 = available, 0 = not available.
@@ -88,11 +104,30 @@
 /// SWO Trace Buffer Size.
 #define SWO_BUFFER_SIZE         512U           ///< SWO Trace Buffer Size in bytes (must be 2^n).
 
+/// SWO Trace Buffer policy when full.
+/// Dropping the newest data is reported as a trace buffer overrun.
+#define SWO_BUFFER_OVERWRITE    0               ///< 1 = drop the oldest data, 0 = drop the newest data.
+
 /// SWO Streaming Trace.
 #define SWO_STREAM              0               ///< SWO Streaming Trace: 1 = available, 0 = not available.
 
+/// SWO Streaming Trace aggregation.
+/// A stream transfer starts once a block is buffered, or when data has been pending for the timeout.
+#define SWO_STREAM_BLOCK_SIZE   512U            ///< Maximum stream transfer in bytes.
+#define SWO_STREAM_TIMEOUT      50U             ///< Flush timeout in ms.
+
+/// Filter ITM/DWT packets of the SWO trace on the probe.
+/// Packets not selected by \ref SWO_ITM_PORTS and \ref SWO_ITM_PACKETS are dropped before the trace buffer.
+#define SWO_ITM_FILTER          0               ///< SWO ITM filter: 1 = available, 0 = not available.
+
+/// ITM stimulus ports kept by the SWO ITM filter.
+#define SWO_ITM_PORTS           0xFFFFFFFFU     ///< Bit n keeps stimulus port n.
+
+/// ITM/DWT packet types kept by the SWO ITM filter (ITM_FILTER_* in itm_filter.h).
+#define SWO_ITM_PACKETS         0x3FU           ///< 0x3F keeps all packet types.
+
 /// Clock frequency of the Test Domain Timer. Timer value is returned with \ref TIMESTAMP_GET.
-#define TIMESTAMP_CLOCK         0U      ///< Timestamp clock in Hz (0 = timestamps not supported).
+#define TIMESTAMP_CLOCK         48000000U       ///< Timestamp clock in Hz (0 = timestamps not supported).
 
 /// Indicate that UART Communication Port is available.
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
@@ -111,6 +146,12 @@
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
 #define DAP_UART_USB_COM_PORT   1               ///< USB COM Port:  1 = available, 0 = not available.
 
+/// Run flash algorithms on the probe with the vendor commands in DAP_vendor.c.
+#define DAP_FLASH_RUNNER        0               ///< Flash runner: 1 = available, 0 = not available.
+
+/// Verify, download and read target memory on the probe with the vendor commands in DAP_vendor.c.
+#define DAP_MEM_COMMANDS        0               ///< Memory commands: 1 = available, 0 = not available.
+
 /// Debug Unit is connected to fixed Target Device.
 /// The Debug Unit may be part of an evaluation board and always connected to a fixed
 /// known device. In this case a Device Vendor, Device Name, Board Vendor and Board Name strings
@@ -599,8 +640,9 @@ __STATIC_INLINE void LED_RUNNING_OUT (uint32_t bit) { (void)bit; }
 @{
 Access function for Test Domain Timer.
 
-The value of the Test Domain Timer in the Debug Unit is returned by the function \ref TIMESTAMP_GET. By 
-default, the DWT timer is used.  The frequency of this timer is configured with \ref TIMESTAMP_CLOCK.
+The value of the Test Domain Timer in the Debug Unit is returned by the function \ref TIMESTAMP_GET.
+Cortex-M0 has no DWT cycle counter, so the 32-bit timer CT32B1 runs free at the system clock
+instead. The frequency of this timer is configured with \ref TIMESTAMP_CLOCK.
 
 */
 
@@ -609,7 +651,7 @@ default, the DWT timer is used.  The frequency of this timer is configured with
 */
 __STATIC_INLINE uint32_t TIMESTAMP_GET (void) {
 #if (TIMESTAMP_CLOCK != 0)
-  return (DWT->CYCCNT);
+  return (LPC_TIMER32_1->TC);
 #else
   return 0;
 #endif
@@ -647,6 +689,14 @@ __STATIC_INLINE void DAP_SETUP (void) {
   PIN_nTRST_IOCON     = PIN_nTRST_FUNC | PIN_PULL_UP | PIN_OPEN_DRAIN | PIN_DIGIT;
 #endif
   PIN_CONNECTED_IOCON = PIN_CONNECTED_FUNC | PIN_DIGIT;
+
+#if (TIMESTAMP_CLOCK != 0)
+  /* Test Domain Timer: CT32B1 counting system clock cycles */
+  Chip_TIMER_Init(LPC_TIMER32_1);
+  Chip_TIMER_PrescaleSet(LPC_TIMER32_1, 0);
+  Chip_TIMER_Reset(LPC_TIMER32_1);
+  Chip_TIMER_Enable(LPC_TIMER32_1);
+#endif
 }
 
 /** Reset Target Device with custom specific I/O pin or command sequence.
@@ -43,6 +43,17 @@ void USB_IRQHandler(void)
 #define BUTTON_PIN            1
 #define BUTTON_STATE_ACTIVE   0
 
+// UART bridge ring buffers, 2^n bytes.
+// RX holds about 20ms at 115200 baud while the main loop is busy with DAP
+// commands; TX only needs to absorb one CDC packet.
+#define UART_RX_RB_SIZE       256
+#define UART_TX_RB_SIZE       128
+
+static RINGBUFF_T uart_rx_rb;
+static RINGBUFF_T uart_tx_rb;
+static uint8_t uart_rx_buf[UART_RX_RB_SIZE];
+static uint8_t uart_tx_buf[UART_TX_RB_SIZE];
+
 /* System oscillator rate and RTC oscillator rate */
 const uint32_t OscRateIn = 12000000;
 const uint32_t ExtRateIn = 0;
@@ -168,6 +179,18 @@ void board_init(void)
   Chip_Clock_EnablePeriphClock(SYSCTL_CLOCK_USBRAM);
   /* power UP USB Phy */
   Chip_SYSCTL_PowerUp(SYSCTL_POWERDOWN_USBPAD_PD);
+
+  // UART: the interrupt moves data between the FIFOs and the ring buffers
+  RingBuffer_Init(&uart_rx_rb, uart_rx_buf, 1, UART_RX_RB_SIZE);
+  RingBuffer_Init(&uart_tx_rb, uart_tx_buf, 1, UART_TX_RB_SIZE);
+  Chip_UART_SetupFIFOS(LPC_USART, (UART_FCR_FIFO_EN | UART_FCR_RX_RS | UART_FCR_TX_RS | UART_FCR_TRG_LEV2));
+  Chip_UART_IntEnable(LPC_USART, (UART_IER_RBRINT | UART_IER_RLSINT));
+  NVIC_EnableIRQ(UART0_IRQn);
+}
+
+void UART_IRQHandler(void)
+{
+  Chip_UART_IRQRBHandler(LPC_USART, &uart_rx_rb, &uart_tx_rb);
 }
 
 //--------------------------------------------------------------------+
@@ -191,14 +214,40 @@ uint32_t board_uart_set_baudrate(unsigned bit_rate)
   return Chip_UART_SetBaud(LPC_USART, bit_rate);
 }
 
+int board_uart_set_format(unsigned data_bits, unsigned parity, unsigned stop_bits)
+{
+  static const uint32_t parities[] = {
+    UART_LCR_PARITY_DIS,
+    UART_LCR_PARITY_EN | UART_LCR_PARITY_ODD,
+    UART_LCR_PARITY_EN | UART_LCR_PARITY_EVEN,
+    UART_LCR_PARITY_EN | UART_LCR_PARITY_F_1,
+    UART_LCR_PARITY_EN | UART_LCR_PARITY_F_0,
+  };
+  if ((data_bits < 5U) || (data_bits > 8U) || (parity > 4U) || (stop_bits > 2U))
+    return 0;
+  // The stop bit select gives 1.5 stop bits with 5 data bits, 2 otherwise
+  if (stop_bits && ((stop_bits == 1U) != (data_bits == 5U)))
+    return 0;
+  Chip_UART_ConfigData(LPC_USART, (UART_LCR_WLEN5 + (data_bits - 5U)) |
+                       (stop_bits ? UART_LCR_SBS_2BIT : UART_LCR_SBS_1BIT) | parities[parity]);
+  return 1;
+}
+
 int board_uart_read(uint8_t* buf, int len)
 {
-  return Chip_UART_Read(LPC_USART, buf, len);
+  return Chip_UART_ReadRB(LPC_USART, &uart_rx_rb, buf, len);
+}
+
+// The receive interrupt drops data silently when uart_rx_rb is full
+int board_uart_rx_overrun(void)
+{
+  return 0;
 }
 
+// Queue as much of buf as fits without blocking.
 int board_uart_write(void const * buf, int len)
 {
-  return Chip_UART_Send(LPC_USART, buf, len);
+  return Chip_UART_SendRB(LPC_USART, &uart_tx_rb, buf, len);
 }
 
 #if CFG_TUSB_OS == OPT_OS_NONE
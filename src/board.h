@@ -34,11 +34,27 @@ extern "C" {
 
 void board_init(void);
 uint32_t board_uart_set_baudrate(unsigned bit_rate);
+// parity and stop_bits are coded as in CDC line coding:
+//   parity:    0 = none, 1 = odd, 2 = even, 3 = mark, 4 = space
+//   stop_bits: 0 = 1, 1 = 1.5, 2 = 2
+//   return:    1 if applied, 0 if not supported
+int board_uart_set_format(unsigned data_bits, unsigned parity, unsigned stop_bits);
 int board_uart_read(uint8_t* buf, int len);
+// return: 1 if received data was lost since the last call
+int board_uart_rx_overrun(void);
 int board_uart_write(void const * buf, int len);
 int board_swo_set_enabled(int enabled);
 uint32_t board_swo_set_baudrate(unsigned bit_rate);
+int board_swo_manchester_set_enabled(int enabled);
+uint32_t board_swo_manchester_set_baudrate(unsigned bit_rate);
 int board_swo_read(uint8_t* buf, int len);
+int board_swo_start_capture(uint8_t* buf, unsigned size);
+void board_swo_stop_capture(void);
+unsigned board_swo_captured(bool* overrun);
+void board_multicore_launch(void (*entry)(void));
+// Continue a CRC-32 over buf, as crc32_update() does
+uint32_t board_crc32_update(uint32_t crc, void const * buf, unsigned len);
+uint32_t board_millis(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,649 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+// Vendor commands.
+// This replaces the template lib/CMSIS-DAP/Firmware/Source/DAP_vendor.c.
+//
+// Target memory is accessed through the MEM-AP that the host has selected,
+// by running DAP_Transfer and DAP_TransferBlock commands on the probe. The
+// host must have connected the debug port, powered it up and selected the
+// AP before it uses these commands. The CSW and TAR registers of the AP are
+// restored to the host's values when a command completes.
+
+#include <string.h>
+
+#include "DAP_config.h"
+#include "DAP.h"
+#include "board.h"
+#include "flash_runner.h"
+#include "crc32.h"
+#include "rle.h"
+
+//--------------------------------------------------------------------+
+// Vendor command IDs
+//--------------------------------------------------------------------+
+#define ID_DAP_FLASH_Setup      ID_DAP_Vendor16
+#define ID_DAP_FLASH_Init       ID_DAP_Vendor17
+#define ID_DAP_FLASH_UnInit     ID_DAP_Vendor18
+#define ID_DAP_FLASH_Erase      ID_DAP_Vendor19
+#define ID_DAP_FLASH_Write      ID_DAP_Vendor20
+#define ID_DAP_FLASH_Flush      ID_DAP_Vendor21
+#define ID_DAP_MEM_Crc32        ID_DAP_Vendor24
+#define ID_DAP_MEM_Compare      ID_DAP_Vendor25
+#define ID_DAP_MEM_WriteRle     ID_DAP_Vendor26
+#define ID_DAP_MEM_ReadRle      ID_DAP_Vendor27
+
+//--------------------------------------------------------------------+
+// MEM-AP access
+//--------------------------------------------------------------------+
+#define AP_CSW                  (DAP_TRANSFER_APnDP)
+#define AP_TAR                  (DAP_TRANSFER_APnDP | DAP_TRANSFER_A2)
+#define AP_DRW                  (DAP_TRANSFER_APnDP | DAP_TRANSFER_A2 | DAP_TRANSFER_A3)
+
+#define CSW_SIZE_ADDRINC_Msk    0x37U
+#define CSW_SIZE32_ADDRINC      0x12U   // word access, single auto-increment
+
+// TAR auto-increment is only guaranteed within a 1KB block
+#define TAR_WRAP                0x400U
+
+// Words per DAP_TransferBlock run on the probe
+#define BLOCK_WORDS             64U
+
+#define DHCSR                   0xE000EDF0U
+#define DCRSR                   0xE000EDF4U
+#define DCRDR                   0xE000EDF8U
+#define DBGKEY                  0xA05F0000U
+#define C_DEBUGEN               (1U << 0)
+#define C_HALT                  (1U << 1)
+#define C_MASKINTS              (1U << 3)
+#define S_REGRDY                (1U << 16)
+#define S_HALT                  (1U << 17)
+#define REGWnR                  (1U << 16)
+
+// Transfers of one DAP_Transfer command
+#define XFER_MAX                6U
+
+typedef struct {
+  uint8_t  request[3U + (XFER_MAX * 5U)];
+  uint32_t len;
+  uint32_t count;
+  uint32_t reads;
+} xfer_t;
+
+static void put32 (uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v >>  0);
+  p[1] = (uint8_t)(v >>  8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t get32 (const uint8_t *p) {
+  return ((uint32_t)p[0] <<  0) |
+         ((uint32_t)p[1] <<  8) |
+         ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static void xfer_begin (xfer_t *x) {
+  x->request[0] = ID_DAP_Transfer;
+  x->request[1] = 0U;   // DAP index
+  x->len   = 3U;
+  x->count = 0U;
+  x->reads = 0U;
+}
+
+static void xfer_write (xfer_t *x, uint8_t req, uint32_t value) {
+  x->request[x->len++] = req;
+  put32(&x->request[x->len], value);
+  x->len += 4U;
+  x->count++;
+}
+
+static void xfer_read (xfer_t *x, uint8_t req) {
+  x->request[x->len++] = req | DAP_TRANSFER_RnW;
+  x->count++;
+  x->reads++;
+}
+
+// Run the transfers.
+//   data:   read values in order, may be NULL if nothing is read
+//   return: true if all transfers completed with OK
+static bool xfer_run (xfer_t *x, uint32_t *data) {
+  uint8_t response[3U + (XFER_MAX * 4U)];
+
+  x->request[2] = (uint8_t)x->count;
+  response[1] = 0U;
+  DAP_ProcessCommand(x->request, response);
+  if ((response[1] != x->count) || (response[2] != DAP_TRANSFER_OK)) {
+    return false;
+  }
+  for (uint32_t i = 0U; i < x->reads; i++) {
+    data[i] = get32(&response[3U + (i * 4U)]);
+  }
+  return true;
+}
+
+static bool mem_write32 (uint32_t addr, uint32_t value) {
+  xfer_t x;
+  xfer_begin(&x);
+  xfer_write(&x, AP_TAR, addr);
+  xfer_write(&x, AP_DRW, value);
+  return xfer_run(&x, NULL);
+}
+
+static bool mem_read32 (uint32_t addr, uint32_t *value) {
+  xfer_t x;
+  uint32_t data[XFER_MAX];
+  xfer_begin(&x);
+  xfer_write(&x, AP_TAR, addr);
+  xfer_read(&x, AP_DRW);
+  if (!xfer_run(&x, data)) return false;
+  *value = data[0];
+  return true;
+}
+
+// Write words from a byte stream with DAP_TransferBlock.
+//   addr, len: word aligned
+static bool mem_write_block (uint32_t addr, const uint8_t *data, uint32_t len) {
+  static uint8_t request[5U + (BLOCK_WORDS * 4U)];
+  uint8_t response[4];
+
+  while (len) {
+    uint32_t n = TAR_WRAP - (addr & (TAR_WRAP - 1U));
+    if (n > (BLOCK_WORDS * 4U)) n = BLOCK_WORDS * 4U;
+    if (n > len) n = len;
+
+    xfer_t x;
+    xfer_begin(&x);
+    xfer_write(&x, AP_TAR, addr);
+    if (!xfer_run(&x, NULL)) return false;
+
+    request[0] = ID_DAP_TransferBlock;
+    request[1] = 0U;
+    request[2] = (uint8_t)((n / 4U) >> 0);
+    request[3] = (uint8_t)((n / 4U) >> 8);
+    request[4] = AP_DRW;
+    memcpy(&request[5], data, n);
+    DAP_ProcessCommand(request, response);
+    if ((((uint32_t)response[1] | ((uint32_t)response[2] << 8)) != (n / 4U)) ||
+        (response[3] != DAP_TRANSFER_OK)) {
+      return false;
+    }
+    addr += n;
+    data += n;
+    len  -= n;
+  }
+  return true;
+}
+
+// Read words into a byte stream with DAP_TransferBlock.
+//   addr, len: word aligned
+static bool mem_read_block (uint32_t addr, uint8_t *data, uint32_t len) {
+  static uint8_t response[4U + (BLOCK_WORDS * 4U)];
+  uint8_t request[5];
+
+  while (len) {
+    uint32_t n = TAR_WRAP - (addr & (TAR_WRAP - 1U));
+    if (n > (BLOCK_WORDS * 4U)) n = BLOCK_WORDS * 4U;
+    if (n > len) n = len;
+
+    xfer_t x;
+    xfer_begin(&x);
+    xfer_write(&x, AP_TAR, addr);
+    if (!xfer_run(&x, NULL)) return false;
+
+    request[0] = ID_DAP_TransferBlock;
+    request[1] = 0U;
+    request[2] = (uint8_t)((n / 4U) >> 0);
+    request[3] = (uint8_t)((n / 4U) >> 8);
+    request[4] = AP_DRW | DAP_TRANSFER_RnW;
+    DAP_ProcessCommand(request, response);
+    if ((((uint32_t)response[1] | ((uint32_t)response[2] << 8)) != (n / 4U)) ||
+        (response[3] != DAP_TRANSFER_OK)) {
+      return false;
+    }
+    memcpy(data, &response[4], n);
+    addr += n;
+    data += n;
+    len  -= n;
+  }
+  return true;
+}
+
+// CSW and TAR values of the host while the probe uses the AP.
+// Hosts may cache TAR and skip rewriting it before their next DRW access.
+static struct {
+  uint32_t csw;
+  uint32_t tar;
+  bool     restore_csw;
+} HostAP;
+
+// Select word accesses with auto-increment, keeping the host's CSW and TAR.
+static bool mem_begin (void) {
+  xfer_t x;
+  uint32_t data[XFER_MAX];
+  HostAP.restore_csw = false;
+  xfer_begin(&x);
+  xfer_read(&x, AP_CSW);
+  xfer_read(&x, AP_TAR);
+  if (!xfer_run(&x, data)) return false;
+  HostAP.csw = data[0];
+  HostAP.tar = data[1];
+  if ((data[0] & CSW_SIZE_ADDRINC_Msk) == CSW_SIZE32_ADDRINC) return true;
+  HostAP.restore_csw = true;
+  xfer_begin(&x);
+  xfer_write(&x, AP_CSW, (data[0] & ~CSW_SIZE_ADDRINC_Msk) | CSW_SIZE32_ADDRINC);
+  return xfer_run(&x, NULL);
+}
+
+static void mem_end (void) {
+  xfer_t x;
+  xfer_begin(&x);
+  if (HostAP.restore_csw) {
+    xfer_write(&x, AP_CSW, HostAP.csw);
+  }
+  xfer_write(&x, AP_TAR, HostAP.tar);
+  xfer_run(&x, NULL);
+}
+
+#if (DAP_FLASH_RUNNER != 0)
+//--------------------------------------------------------------------+
+// Flash runner target
+//--------------------------------------------------------------------+
+static bool wait_regrdy (void) {
+  uint32_t dhcsr;
+  for (uint32_t i = 0U; i < 100U; i++) {
+    if (!mem_read32(DHCSR, &dhcsr)) return false;
+    if (dhcsr & S_REGRDY) return true;
+  }
+  return false;
+}
+
+static bool target_write_mem (void *ctx, uint32_t addr, const uint8_t *data, uint32_t len) {
+  (void)ctx;
+  return mem_write_block(addr, data, len);
+}
+
+static bool target_write_reg (void *ctx, uint32_t reg, uint32_t value) {
+  xfer_t x;
+  (void)ctx;
+  xfer_begin(&x);
+  xfer_write(&x, AP_TAR, DCRDR);
+  xfer_write(&x, AP_DRW, value);
+  xfer_write(&x, AP_TAR, DCRSR);
+  xfer_write(&x, AP_DRW, reg | REGWnR);
+  return xfer_run(&x, NULL) && wait_regrdy();
+}
+
+static bool target_read_reg (void *ctx, uint32_t reg, uint32_t *value) {
+  (void)ctx;
+  return mem_write32(DCRSR, reg) && wait_regrdy() && mem_read32(DCRDR, value);
+}
+
+// C_MASKINTS may only change while the core is halted, so set it before
+// C_HALT is cleared.
+static bool target_resume (void *ctx) {
+  xfer_t x;
+  (void)ctx;
+  xfer_begin(&x);
+  xfer_write(&x, AP_TAR, DHCSR);
+  xfer_write(&x, AP_DRW, DBGKEY | C_DEBUGEN | C_HALT | C_MASKINTS);
+  xfer_write(&x, AP_TAR, DHCSR);
+  xfer_write(&x, AP_DRW, DBGKEY | C_DEBUGEN | C_MASKINTS);
+  return xfer_run(&x, NULL);
+}
+
+static bool target_halted (void *ctx, bool *halted) {
+  uint32_t dhcsr;
+  (void)ctx;
+  if (!mem_read32(DHCSR, &dhcsr)) return false;
+  *halted = (dhcsr & S_HALT) != 0U;
+  return true;
+}
+
+static uint32_t target_millis (void *ctx) {
+  (void)ctx;
+  return board_millis();
+}
+
+static const flash_target_t flash_target = {
+  .ctx       = NULL,
+  .write_mem = target_write_mem,
+  .write_reg = target_write_reg,
+  .read_reg  = target_read_reg,
+  .resume    = target_resume,
+  .halted    = target_halted,
+  .millis    = target_millis,
+};
+
+static flash_runner_t flash_runner;
+
+// Process FLASH_Setup command
+//   request:  breakpoint, static base, stack pointer, Init, UnInit,
+//             EraseSector, ProgramPage, buffer 0, buffer 1, page size,
+//             timeout in ms (words)
+//   response: status
+static uint32_t FLASH_Setup (const uint8_t *request, uint8_t *response) {
+  flash_algo_t algo;
+  algo.breakpoint      = get32(request +  0);
+  algo.static_base     = get32(request +  4);
+  algo.stack_pointer   = get32(request +  8);
+  algo.pc_init         = get32(request + 12);
+  algo.pc_uninit       = get32(request + 16);
+  algo.pc_erase_sector = get32(request + 20);
+  algo.pc_program_page = get32(request + 24);
+  algo.buffer[0]       = get32(request + 28);
+  algo.buffer[1]       = get32(request + 32);
+  algo.page_size       = get32(request + 36);
+  algo.timeout_ms      = get32(request + 40);
+  if ((algo.buffer[0] | algo.buffer[1] | algo.page_size) & 3U) {
+    algo.page_size = 0U;  // rejected by flash_runner_setup
+  }
+  *response = (uint8_t)flash_runner_setup(&flash_runner, &flash_target, &algo);
+  return ((44U << 16) | 1U);
+}
+
+// Run one flash runner operation with word access selected
+//   op:       FLASH_* command ID
+//   request:  command parameters
+//   response: status, R0 of the last call (word)
+//   return:   number of bytes in request (upper 16 bits)
+static uint32_t FLASH_Run (uint8_t op, const uint8_t *request, uint8_t *response) {
+  uint32_t status = FLASH_RUNNER_ERR_TARGET;
+  uint32_t req_len = 0U;
+
+  switch (op) {
+    case ID_DAP_FLASH_Init:   req_len = 12U; break;
+    case ID_DAP_FLASH_UnInit: req_len =  4U; break;
+    case ID_DAP_FLASH_Erase:  req_len =  4U; break;
+    case ID_DAP_FLASH_Write:  req_len =  6U + ((uint32_t)request[4] | ((uint32_t)request[5] << 8)); break;
+    default: break;
+  }
+
+  if (mem_begin()) {
+    switch (op) {
+      case ID_DAP_FLASH_Init:
+        status = flash_runner_init(&flash_runner, get32(request), get32(request + 4), get32(request + 8));
+        break;
+      case ID_DAP_FLASH_UnInit:
+        status = flash_runner_uninit(&flash_runner, get32(request));
+        break;
+      case ID_DAP_FLASH_Erase:
+        status = flash_runner_erase(&flash_runner, get32(request));
+        break;
+      case ID_DAP_FLASH_Write:
+        if (((req_len - 6U) & 3U) || ((req_len + 1U) > DAP_PACKET_SIZE)) {
+          status = FLASH_RUNNER_ERR_PARAM;
+        } else {
+          status = flash_runner_write(&flash_runner, get32(request), request + 6, req_len - 6U);
+        }
+        break;
+      case ID_DAP_FLASH_Flush:
+        status = flash_runner_flush(&flash_runner);
+        break;
+      default:
+        break;
+    }
+    mem_end();
+  }
+
+  response[0] = (uint8_t)status;
+  put32(&response[1], flash_runner.result);
+  return ((req_len << 16) | 5U);
+}
+#endif  /* (DAP_FLASH_RUNNER != 0) */
+
+#if (DAP_MEM_COMMANDS != 0)
+//--------------------------------------------------------------------+
+// Memory commands
+//--------------------------------------------------------------------+
+// Chunks of MemBuf never cross a TAR wrap when they are aligned to its size,
+// so each one takes a single DAP_TransferBlock.
+static uint8_t MemBuf[BLOCK_WORDS * 4U];
+
+// Continue a CRC-32 over target memory.
+//   addr, len: word aligned
+static bool mem_crc32 (uint32_t addr, uint32_t len, uint32_t *crc) {
+  while (len) {
+    uint32_t n = sizeof(MemBuf) - (addr & (sizeof(MemBuf) - 1U));
+    if (n > len) n = len;
+    if (!mem_read_block(addr, MemBuf, n)) return false;
+    *crc = board_crc32_update(*crc, MemBuf, n);
+    addr += n;
+    len  -= n;
+  }
+  return true;
+}
+
+// Process MEM_Crc32 command
+//   request:  address, length in bytes, initial CRC (words)
+//             address and length must be word aligned
+//   response: status, CRC-32 of the range (word)
+// The initial CRC is 0 for a new range, or the result for the previous
+// range to continue it.
+static uint32_t MEM_Crc32 (const uint8_t *request, uint8_t *response) {
+  uint32_t addr = get32(request + 0);
+  uint32_t len  = get32(request + 4);
+  uint32_t crc  = get32(request + 8);
+  uint8_t status = DAP_ERROR;
+
+  if ((((addr | len) & 3U) == 0U) && mem_begin()) {
+    if (mem_crc32(addr, len, &crc)) {
+      status = DAP_OK;
+    }
+    mem_end();
+  }
+  response[0] = status;
+  put32(&response[1], crc);
+  return ((12U << 16) | 5U);
+}
+
+// Sectors of one MEM_Compare command
+#define COMPARE_MAX             ((DAP_PACKET_SIZE - 6U) / 8U)
+
+// Process MEM_Compare command
+//   request:  sector size (word), sector count (byte),
+//             address and expected CRC-32 of each sector (words)
+//             addresses and sector size must be word aligned
+//   response: status, bitmap of sectors that differ (bit n for sector n)
+// Sectors that could not be read are reported as different.
+static uint32_t MEM_Compare (const uint8_t *request, uint8_t *response) {
+  uint32_t size  = get32(request);
+  uint32_t count = request[4];
+  uint32_t bytes = (count + 7U) / 8U;
+  uint8_t status = DAP_ERROR;
+
+  if (count > COMPARE_MAX) {
+    response[0] = DAP_ERROR;
+    return ((5U << 16) | 1U);
+  }
+  memset(&response[1], 0xFF, bytes);
+  if (((size & 3U) == 0U) && mem_begin()) {
+    status = DAP_OK;
+    for (uint32_t n = 0U; n < count; n++) {
+      const uint8_t *sector = request + 5U + (n * 8U);
+      uint32_t addr = get32(sector);
+      uint32_t crc  = CRC32_INIT;
+      if ((addr & 3U) || !mem_crc32(addr, size, &crc)) {
+        status = DAP_ERROR;
+        break;
+      }
+      if (crc == get32(sector + 4)) {
+        response[1U + (n / 8U)] &= (uint8_t)~(1U << (n % 8U));
+      }
+    }
+    mem_end();
+  }
+  if (count % 8U) {
+    response[bytes] &= (uint8_t)((1U << (count % 8U)) - 1U);
+  }
+  response[0] = status;
+  return (((5U + (count * 8U)) << 16) | (1U + bytes));
+}
+
+// Write count copies of a word to target memory.
+//   addr: word aligned
+static bool mem_fill (uint32_t addr, uint32_t value, uint32_t count) {
+  uint32_t n = (count < BLOCK_WORDS) ? count : BLOCK_WORDS;
+  for (uint32_t i = 0U; i < n; i++) {
+    put32(&MemBuf[i * 4U], value);
+  }
+  while (count) {
+    n = (sizeof(MemBuf) - (addr & (sizeof(MemBuf) - 1U))) / 4U;
+    if (n > count) n = count;
+    if (!mem_write_block(addr, MemBuf, n * 4U)) return false;
+    addr  += n * 4U;
+    count -= n;
+  }
+  return true;
+}
+
+// Process MEM_WriteRle command
+//   request:  address (word), stream length (short), run-length coded stream
+//             address must be word aligned, the stream holds whole tokens
+//   response: status, number of words written (word)
+static uint32_t MEM_WriteRle (const uint8_t *request, uint8_t *response) {
+  uint32_t addr  = get32(request);
+  uint32_t len   = (uint32_t)request[4] | ((uint32_t)request[5] << 8);
+  uint32_t req_len = 6U + len;
+  const uint8_t *src = request + 6;
+  uint32_t words = 0U;
+  uint8_t status = DAP_ERROR;
+
+  if (((addr & 3U) == 0U) && ((req_len + 1U) <= DAP_PACKET_SIZE) && mem_begin()) {
+    status = DAP_OK;
+    while (len) {
+      rle_token_t token;
+      uint32_t n = rle_parse(src, len, &token);
+      bool ok;
+      if (n == 0U) {
+        status = DAP_ERROR;
+        break;
+      }
+      if (token.data) {
+        ok = mem_write_block(addr, token.data, token.count * 4U);
+      } else {
+        ok = mem_fill(addr, token.value, token.count);
+      }
+      if (!ok) {
+        status = DAP_ERROR;
+        break;
+      }
+      addr  += token.count * 4U;
+      words += token.count;
+      src   += n;
+      len   -= n;
+    }
+    mem_end();
+  }
+  response[0] = status;
+  put32(&response[1], words);
+  return ((req_len << 16) | 5U);
+}
+
+// Process MEM_ReadRle command
+//   request:  address, number of words (words)
+//             address must be word aligned
+//   response: status, number of words read (word), stream length (short),
+//             run-length coded stream of the words read
+// Reading stops when the stream fills the response. The host continues
+// with the address after the words read.
+static uint32_t MEM_ReadRle (const uint8_t *request, uint8_t *response) {
+  uint32_t addr  = get32(request + 0);
+  uint32_t count = get32(request + 4);
+  uint8_t status = DAP_ERROR;
+  rle_encoder_t e;
+
+  rle_encoder_init(&e, &response[7], DAP_PACKET_SIZE - 8U);
+  if (((addr & 3U) == 0U) && mem_begin()) {
+    status = DAP_OK;
+    while (count) {
+      uint32_t n = (sizeof(MemBuf) - (addr & (sizeof(MemBuf) - 1U))) / 4U;
+      uint32_t i;
+      if (n > count) n = count;
+      if (!mem_read_block(addr, MemBuf, n * 4U)) {
+        status = DAP_ERROR;
+        break;
+      }
+      for (i = 0U; i < n; i++) {
+        if (!rle_encode(&e, get32(&MemBuf[i * 4U]))) break;
+      }
+      if (i < n) break;
+      addr  += n * 4U;
+      count -= n;
+    }
+    mem_end();
+  }
+  uint32_t len = rle_encoder_finish(&e);
+  response[0] = status;
+  put32(&response[1], e.words);
+  response[5] = (uint8_t)(len >> 0);
+  response[6] = (uint8_t)(len >> 8);
+  return ((8U << 16) | (7U + len));
+}
+#endif  /* (DAP_MEM_COMMANDS != 0) */
+
+// Process DAP Vendor Command and prepare Response Data
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t DAP_ProcessVendorCommand (const uint8_t *request, uint8_t *response) {
+  uint32_t num = (1U << 16) | 1U;
+  uint8_t  id  = *request++;
+
+  *response++ = id;             // copy Command ID
+
+  switch (id) {
+#if (DAP_FLASH_RUNNER != 0)
+    case ID_DAP_FLASH_Setup:
+      num += FLASH_Setup(request, response);
+      break;
+    case ID_DAP_FLASH_Init:
+    case ID_DAP_FLASH_UnInit:
+    case ID_DAP_FLASH_Erase:
+    case ID_DAP_FLASH_Write:
+    case ID_DAP_FLASH_Flush:
+      num += FLASH_Run(id, request, response);
+      break;
+#endif
+#if (DAP_MEM_COMMANDS != 0)
+    case ID_DAP_MEM_Crc32:
+      num += MEM_Crc32(request, response);
+      break;
+    case ID_DAP_MEM_Compare:
+      num += MEM_Compare(request, response);
+      break;
+    case ID_DAP_MEM_WriteRle:
+      num += MEM_WriteRle(request, response);
+      break;
+    case ID_DAP_MEM_ReadRle:
+      num += MEM_ReadRle(request, response);
+      break;
+#endif
+    default:
+      *(response-1) = ID_DAP_Invalid;
+      break;
+  }
+
+  return (num);
+}
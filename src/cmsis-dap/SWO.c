@@ -38,9 +38,13 @@
 #if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
 
 
+#ifndef SWO_STREAM_TIMEOUT
 #define SWO_STREAM_TIMEOUT      50U     /* Stream timeout in ms */
+#endif
 
+#ifndef USB_BLOCK_SIZE
 #define USB_BLOCK_SIZE          512U    /* USB Block Size */
+#endif
 
 // Trace State
 static uint8_t  TraceTransport =  0U;       /* Trace Transport */
@@ -49,21 +53,29 @@ static uint8_t  TraceStatus    =  0U;       /* Trace Status without Errors */
 static uint8_t  TraceError[2]  = {0U, 0U};  /* Trace Error flags (banked) */
 static uint8_t  TraceError_n   =  0U;       /* Active Trace Error bank */
 
+#if (DAP_DUAL_CORE != 0)
+// SetTraceError runs on the core that captures trace data, while commands
+// read and clear the errors on the other core. Each error flag is counted
+// by the capturing core and taken by the command core, so that every
+// variable has a single writer.
+static volatile uint8_t TraceErrorRaised[8];
+static uint8_t          TraceErrorTaken[8];
+#endif
+
 #if (TIMESTAMP_CLOCK != 0U)
 // Trace Timestamp
 static volatile struct {
   uint32_t index;
   uint32_t tick;
 } TraceTimestamp;
+static volatile uint8_t TraceUpdate;        /* Trace Timestamp updated */
 #endif
 
 // Trace Helper functions
 static void     ClearTrace     (void);
 static uint32_t GetTraceCount  (void);
 uint8_t  GetTraceStatus (void);
-#if 0
-static void     SetTraceError  (uint8_t flag);
-#endif
+void     SetTraceError  (uint8_t flag);
 // Trace Buffer functions
 uint32_t TraceBuffer_IsUpdated(void);
 uint32_t TraceBuffer_GetCount(void);
@@ -102,14 +114,38 @@ __WEAK void SWO_Capture_Manchester (uint8_t *buf, uint32_t num) {
 // Get SWO Pending Trace Count (Manchester)
 //   return: number of pending trace data bytes
 __WEAK uint32_t SWO_GetCount_Manchester (void) {
+  return (0U);
 }
 
 #endif  /* (SWO_MANCHESTER != 0) */
 
 
+#if (DAP_DUAL_CORE != 0)
+// Take Trace Error flag(s) raised since the last call
+//   return: error flag(s)
+static uint8_t TakeTraceError (void) {
+  uint8_t  flags = 0U;
+  uint8_t  raised;
+  uint32_t i;
+
+  for (i = 0U; i < 8U; i++) {
+    raised = TraceErrorRaised[i];
+    if (raised != TraceErrorTaken[i]) {
+      TraceErrorTaken[i] = raised;
+      flags |= (uint8_t)(1U << i);
+    }
+  }
+
+  return (flags);
+}
+#endif
+
 // Clear Trace Errors and Data
 static void ClearTrace (void)
 {
+#if (DAP_DUAL_CORE != 0)
+  (void)TakeTraceError();
+#endif
   TraceError[0] = 0U;
   TraceError[1] = 0U;
   TraceError_n  = 0U;
@@ -121,6 +157,31 @@ static void ClearTrace (void)
 #endif
 }
 
+// Timestamp Trace data added to the trace buffer
+//   num: number of bytes added
+void SWO_CaptureTimestamp (uint32_t num) {
+#if (TIMESTAMP_CLOCK != 0U)
+  TraceTimestamp.index += num;
+  TraceTimestamp.tick   = TIMESTAMP_GET();
+  TraceUpdate = 1U;
+#else
+  (void)num;
+#endif
+}
+
+#if (TIMESTAMP_CLOCK != 0U)
+// Check and clear Trace Timestamp update
+//   return: 1 - updated since the last check, 0 - not updated
+uint32_t TraceBuffer_IsUpdated (void) {
+  uint32_t updated;
+
+  updated = TraceUpdate;
+  TraceUpdate = 0U;
+
+  return (updated);
+}
+#endif
+
 // Get Trace Count
 //   return: number of available data bytes in trace buffer
 uint32_t GetTraceCount (void)
@@ -139,17 +200,28 @@ uint8_t GetTraceStatus (void)
   TraceError_n ^= 1U;
   status = TraceStatus | TraceError[n];
   TraceError[n] = 0U;
+#if (DAP_DUAL_CORE != 0)
+  status |= TakeTraceError();
+#endif
 
   return (status);
 }
 
-#if 0
 // Set Trace Error flag(s)
 //   flag:  error flag(s) to set
-static void SetTraceError (uint8_t flag) {
+void SetTraceError (uint8_t flag) {
+#if (DAP_DUAL_CORE != 0)
+  uint32_t i;
+
+  for (i = 0U; i < 8U; i++) {
+    if ((flag & (1U << i)) != 0U) {
+      TraceErrorRaised[i]++;
+    }
+  }
+#else
   TraceError[TraceError_n] |= flag;
-}
 #endif
+}
 
 
 // Process SWO Transport command and prepare response
@@ -464,4 +536,10 @@ uint32_t SWO_GetTransportMode(void)
   return TraceTransport;
 }
 
+// Get Trace Capture state without clearing Error flags
+uint32_t SWO_IsCaptureActive(void)
+{
+  return TraceStatus & DAP_SWO_CAPTURE_ACTIVE;
+}
+
 #endif  /* ((SWO_UART != 0) || (SWO_MANCHESTER != 0)) */
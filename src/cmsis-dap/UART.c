@@ -0,0 +1,461 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+// DAP UART commands over the DAP endpoint.
+// This replaces lib/CMSIS-DAP/Firmware/Source/UART.c, which is built on a
+// CMSIS-Driver USART. The commands only touch the RX/TX rings here and may
+// run on either core; UART_Process moves the ring data to and from the
+// UART in the main loop. UART_Configure hands the new settings over to
+// UART_Process as well, so that only the main loop touches the UART.
+
+#include <string.h>
+
+#include "DAP_config.h"
+#include "DAP.h"
+
+#if (DAP_UART != 0)
+
+#if (DAP_UART_RX_BUFFER_SIZE & (DAP_UART_RX_BUFFER_SIZE - 1U))
+#error "DAP_UART_RX_BUFFER_SIZE must be 2^n"
+#endif
+#if (DAP_UART_TX_BUFFER_SIZE & (DAP_UART_TX_BUFFER_SIZE - 1U))
+#error "DAP_UART_TX_BUFFER_SIZE must be 2^n"
+#endif
+
+// DAP_UART_Configure Control
+#define UART_CFG_DATA_BITS_Msk  0x0FU   // 5 .. 8
+#define UART_CFG_PARITY_Pos     4U
+#define UART_CFG_PARITY_Msk     (3U << UART_CFG_PARITY_Pos)
+#define UART_CFG_STOP_BITS_Pos  6U
+#define UART_CFG_STOP_BITS_Msk  (3U << UART_CFG_STOP_BITS_Pos)
+
+// Bytes moved per UART_Process call
+#define UART_CHUNK_SIZE         64U
+
+static volatile uint8_t UartTransport =
+#if (DAP_UART_USB_COM_PORT != 0)
+  DAP_UART_TRANSPORT_USB_COM_PORT;
+#else
+  DAP_UART_TRANSPORT_NONE;
+#endif
+static volatile uint8_t UartRxEnabled;
+static volatile uint8_t UartTxEnabled;
+static volatile uint8_t UartError;          /* DAP_UART_STATUS_*_LOST, cleared by UART_Status */
+
+// Free running ring indices: the main loop produces RX and consumes TX data,
+// the DAP commands do the opposite.
+static volatile uint32_t UartRxWr, UartRxRd;
+static volatile uint32_t UartTxWr, UartTxRd;
+static volatile uint32_t UartTxFlush;       /* TX data before this index is discarded */
+static uint8_t UartRxBuf[DAP_UART_RX_BUFFER_SIZE];
+static uint8_t UartTxBuf[DAP_UART_TX_BUFFER_SIZE];
+
+// Settings of UART_Configure, applied by ApplyConfig
+static struct {
+  uint32_t baudrate;    /* requested, then actual baudrate */
+  uint8_t  data_bits;
+  uint8_t  parity;
+  uint8_t  stop_bits;
+  uint8_t  format;      /* frame format: 1 = apply, then 1 = applied */
+} UartConfig;
+#if (DAP_DUAL_CORE != 0)
+static volatile uint8_t UartConfigPending;  /* set by the command core, cleared by UART_Process */
+#endif
+
+#if (DAP_DUAL_CORE != 0)
+// Order ring accesses against the index that hands them over to the other core.
+# define ring_barrier()    __DMB()
+#else
+# define ring_barrier()
+#endif
+
+// Configure UART Baudrate
+//   baudrate: requested baudrate
+//   return:   actual baudrate or 0 when not configured
+__WEAK uint32_t UART_Baudrate (uint32_t baudrate) {
+  (void)baudrate;
+  return (0U);
+}
+
+// Configure UART Frame Format
+//   data_bits: 5 .. 8
+//   parity:    0 = none, 1 = odd, 2 = even, 3 = mark
+//   stop_bits: 0 = 1, 1 = 1.5, 2 = 2
+//   return:    1 - Success, 0 - Error
+__WEAK uint32_t UART_Format (uint32_t data_bits, uint32_t parity, uint32_t stop_bits) {
+  return ((data_bits == 8U) && (parity == 0U) && (stop_bits == 0U)) ? 1U : 0U;
+}
+
+// Read received data from the UART without blocking
+//   buf:    pointer to buffer
+//   num:    maximum number of bytes
+//   return: number of bytes read
+__WEAK uint32_t UART_Read (uint8_t *buf, uint32_t num) {
+  (void)buf;
+  (void)num;
+  return (0U);
+}
+
+// Check and clear data loss before UART_Read
+//   return: 1 - received data was lost, 0 - no loss
+__WEAK uint32_t UART_RxOverrun (void) {
+  return (0U);
+}
+
+// Queue data to the UART without blocking
+//   buf:    pointer to data
+//   num:    number of bytes
+//   return: number of bytes queued
+__WEAK uint32_t UART_Write (const uint8_t *buf, uint32_t num) {
+  (void)buf;
+  (void)num;
+  return (0U);
+}
+
+// Copy num bytes at the free running index idx into a ring
+static void RingPut (uint8_t *ring, uint32_t size, uint32_t idx, const uint8_t *data, uint32_t num) {
+  uint32_t ofs = idx & (size - 1U);
+  uint32_t n   = (num < (size - ofs)) ? num : (size - ofs);
+  memcpy(&ring[ofs], data, n);
+  memcpy(ring, data + n, num - n);
+}
+
+// Copy num bytes at the free running index idx out of a ring
+static void RingGet (const uint8_t *ring, uint32_t size, uint32_t idx, uint8_t *data, uint32_t num) {
+  uint32_t ofs = idx & (size - 1U);
+  uint32_t n   = (num < (size - ofs)) ? num : (size - ofs);
+  memcpy(data, &ring[ofs], n);
+  memcpy(data + n, ring, num - n);
+}
+
+static void ApplyConfig (void) {
+  if (UartConfig.format) {
+    UartConfig.format = (uint8_t)UART_Format(UartConfig.data_bits, UartConfig.parity, UartConfig.stop_bits);
+  }
+  UartConfig.baudrate = UART_Baudrate(UartConfig.baudrate);
+}
+
+static void FlushRx (void) {
+  UartRxRd = UartRxWr;
+}
+
+static void FlushTx (void) {
+  UartTxFlush = UartTxWr;
+}
+
+// Get the owner of the UART
+//   return: DAP_UART_TRANSPORT_*
+uint32_t UART_GetTransport (void) {
+  return (UartTransport);
+}
+
+// Move data between the UART and the rings while DAP commands own the UART.
+// Call from the main loop.
+void UART_Process (void) {
+  uint8_t  buf[UART_CHUNK_SIZE];
+  uint32_t num, n;
+
+#if (DAP_DUAL_CORE != 0)
+  if (UartConfigPending) {
+    ring_barrier();
+    ApplyConfig();
+    ring_barrier();
+    UartConfigPending = 0U;
+  }
+#endif
+
+  if (UartTransport != DAP_UART_TRANSPORT_DAP_COMMAND) {
+    return;
+  }
+
+  // RX: data that does not fit into the ring is lost
+  if (UartRxEnabled) {
+    num = UART_Read(buf, sizeof(buf));
+    if (UART_RxOverrun() != 0U) {
+      UartError |= DAP_UART_STATUS_RX_DATA_LOST;
+    }
+    if (num) {
+      uint32_t wr = UartRxWr;
+      n = DAP_UART_RX_BUFFER_SIZE - (wr - UartRxRd);
+      if (n < num) {
+        UartError |= DAP_UART_STATUS_RX_DATA_LOST;
+      } else {
+        n = num;
+      }
+      ring_barrier();
+      RingPut(UartRxBuf, DAP_UART_RX_BUFFER_SIZE, wr, buf, n);
+      ring_barrier();
+      UartRxWr = wr + n;
+    }
+  }
+
+  // TX
+  uint32_t rd = UartTxRd;
+  if ((int32_t)(UartTxFlush - rd) > 0) {
+    rd = UartTxFlush;
+  }
+  num = UartTxWr - rd;
+  if (num > sizeof(buf)) {
+    num = sizeof(buf);
+  }
+  if (num && UartTxEnabled) {
+    ring_barrier();
+    RingGet(UartTxBuf, DAP_UART_TX_BUFFER_SIZE, rd, buf, num);
+    rd += UART_Write(buf, num);
+  }
+  ring_barrier();
+  UartTxRd = rd;
+}
+
+// Process UART Transport command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t UART_Transport (const uint8_t *request, uint8_t *response) {
+  uint8_t status = DAP_OK;
+
+  switch (*request) {
+    case DAP_UART_TRANSPORT_NONE:
+    case DAP_UART_TRANSPORT_DAP_COMMAND:
+      break;
+#if (DAP_UART_USB_COM_PORT != 0)
+    case DAP_UART_TRANSPORT_USB_COM_PORT:
+      break;
+#endif
+    default:
+      status = DAP_ERROR;
+      break;
+  }
+  if ((status == DAP_OK) && (UartTransport != *request)) {
+    UartTransport = *request;
+    UartRxEnabled = 0U;
+    UartTxEnabled = 0U;
+    UartError     = 0U;
+    FlushRx();
+    FlushTx();
+  }
+
+  *response = status;
+  return ((1U << 16) | 1U);
+}
+
+// Process UART Configure command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t UART_Configure (const uint8_t *request, uint8_t *response) {
+  uint8_t  control  = *request;
+  uint32_t baudrate = (uint32_t)(*(request+1) <<  0) |
+                      (uint32_t)(*(request+2) <<  8) |
+                      (uint32_t)(*(request+3) << 16) |
+                      (uint32_t)(*(request+4) << 24);
+  uint32_t data_bits = control & UART_CFG_DATA_BITS_Msk;
+  uint32_t parity    = (control & UART_CFG_PARITY_Msk) >> UART_CFG_PARITY_Pos;
+  uint32_t stop_bits = (control & UART_CFG_STOP_BITS_Msk) >> UART_CFG_STOP_BITS_Pos;
+  uint8_t  status    = 0U;
+
+  if ((data_bits < 5U) || (data_bits > 8U)) {
+    status |= DAP_UART_CFG_ERROR_DATA_BITS;
+  }
+  if (stop_bits > 2U) {
+    status |= DAP_UART_CFG_ERROR_STOP_BITS;
+  }
+  UartConfig.baudrate  = baudrate;
+  UartConfig.data_bits = (uint8_t)data_bits;
+  UartConfig.parity    = (uint8_t)parity;
+  UartConfig.stop_bits = (uint8_t)stop_bits;
+  UartConfig.format    = (status == 0U) ? 1U : 0U;
+#if (DAP_DUAL_CORE != 0)
+  // The main loop core owns the UART, wait for it to apply the settings
+  ring_barrier();
+  UartConfigPending = 1U;
+  while (UartConfigPending) {
+  }
+  ring_barrier();
+#else
+  ApplyConfig();
+#endif
+  if ((status == 0U) && (UartConfig.format == 0U)) {
+    // Report the fields that differ from 8N1, which every port supports
+    if (data_bits != 8U) {
+      status |= DAP_UART_CFG_ERROR_DATA_BITS;
+    }
+    if (parity != 0U) {
+      status |= DAP_UART_CFG_ERROR_PARITY;
+    }
+    if (stop_bits != 0U) {
+      status |= DAP_UART_CFG_ERROR_STOP_BITS;
+    }
+  }
+  baudrate = UartConfig.baudrate;
+
+  *(response+0) = status;
+  *(response+1) = (uint8_t)(baudrate >>  0);
+  *(response+2) = (uint8_t)(baudrate >>  8);
+  *(response+3) = (uint8_t)(baudrate >> 16);
+  *(response+4) = (uint8_t)(baudrate >> 24);
+  return ((5U << 16) | 5U);
+}
+
+// Process UART Control command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t UART_Control (const uint8_t *request, uint8_t *response) {
+  uint8_t control = *request;
+  uint8_t status  = DAP_OK;
+
+  if (UartTransport != DAP_UART_TRANSPORT_DAP_COMMAND) {
+    status = DAP_ERROR;
+  } else {
+    if (control & DAP_UART_CONTROL_RX_DISABLE) {
+      UartRxEnabled = 0U;
+    }
+    if (control & DAP_UART_CONTROL_RX_BUF_FLUSH) {
+      FlushRx();
+      UartError &= ~DAP_UART_STATUS_RX_DATA_LOST;
+    }
+    if (control & DAP_UART_CONTROL_RX_ENABLE) {
+      UartRxEnabled = 1U;
+    }
+    if (control & DAP_UART_CONTROL_TX_DISABLE) {
+      UartTxEnabled = 0U;
+    }
+    if (control & DAP_UART_CONTROL_TX_BUF_FLUSH) {
+      FlushTx();
+      UartError &= ~DAP_UART_STATUS_TX_DATA_LOST;
+    }
+    if (control & DAP_UART_CONTROL_TX_ENABLE) {
+      UartTxEnabled = 1U;
+    }
+  }
+
+  *response = status;
+  return ((1U << 16) | 1U);
+}
+
+// Process UART Status command and prepare response
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t UART_Status (uint8_t *response) {
+  uint8_t  status = UartError;
+  uint32_t rx_cnt = UartRxWr - UartRxRd;
+  uint32_t tx_cnt = UartTxWr - UartTxRd;
+
+  UartError = 0U;
+  if ((int32_t)(UartTxFlush - UartTxRd) > 0) {
+    tx_cnt = UartTxWr - UartTxFlush;
+  }
+  if (UartRxEnabled) {
+    status |= DAP_UART_STATUS_RX_ENABLED;
+  }
+  if (UartTxEnabled) {
+    status |= DAP_UART_STATUS_TX_ENABLED;
+  }
+
+  *(response+0) = status;
+  *(response+1) = (uint8_t)(rx_cnt >>  0);
+  *(response+2) = (uint8_t)(rx_cnt >>  8);
+  *(response+3) = (uint8_t)(rx_cnt >> 16);
+  *(response+4) = (uint8_t)(rx_cnt >> 24);
+  *(response+5) = (uint8_t)(tx_cnt >>  0);
+  *(response+6) = (uint8_t)(tx_cnt >>  8);
+  *(response+7) = (uint8_t)(tx_cnt >> 16);
+  *(response+8) = (uint8_t)(tx_cnt >> 24);
+  return ((0U << 16) | 9U);
+}
+
+// Process UART Transfer command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t UART_Transfer (const uint8_t *request, uint8_t *response) {
+  uint32_t rx_cnt, tx_cnt, tx_num, tx_req;
+  uint8_t  status = 0U;
+
+  rx_cnt = (uint32_t)(*(request+0) << 0) |
+           (uint32_t)(*(request+1) << 8);
+  tx_num = (uint32_t)(*(request+2) << 0) |
+           (uint32_t)(*(request+3) << 8);
+  if (rx_cnt > (DAP_PACKET_SIZE - 6U)) {
+    rx_cnt = (DAP_PACKET_SIZE - 6U);
+  }
+  tx_req = tx_num;
+  if (tx_req > (DAP_PACKET_SIZE - 5U)) {
+    tx_req = (DAP_PACKET_SIZE - 5U);
+  }
+
+  if (UartTransport != DAP_UART_TRANSPORT_DAP_COMMAND) {
+    rx_cnt = 0U;
+    tx_cnt = 0U;
+  } else {
+    // TX Data
+    uint32_t wr = UartTxWr;
+    uint32_t rd = UartTxRd;
+    tx_cnt = 0U;
+    if (UartTxEnabled) {
+      tx_cnt = DAP_UART_TX_BUFFER_SIZE - (wr - rd);
+      if (tx_cnt > tx_req) {
+        tx_cnt = tx_req;
+      }
+      ring_barrier();
+      RingPut(UartTxBuf, DAP_UART_TX_BUFFER_SIZE, wr, request + 4, tx_cnt);
+      ring_barrier();
+      UartTxWr = wr + tx_cnt;
+    }
+    if (tx_cnt < tx_req) {
+      UartError |= DAP_UART_STATUS_TX_DATA_LOST;
+    }
+
+    // RX Data
+    wr = UartRxWr;
+    rd = UartRxRd;
+    if (rx_cnt > (wr - rd)) {
+      rx_cnt = wr - rd;
+    }
+    ring_barrier();
+    RingGet(UartRxBuf, DAP_UART_RX_BUFFER_SIZE, rd, response + 5, rx_cnt);
+    ring_barrier();
+    UartRxRd = rd + rx_cnt;
+    status = UartError;
+  }
+  if (UartRxEnabled) {
+    status |= DAP_UART_STATUS_RX_ENABLED;
+  }
+  if (UartTxEnabled) {
+    status |= DAP_UART_STATUS_TX_ENABLED;
+  }
+
+  *(response+0) = status;
+  *(response+1) = (uint8_t)(tx_cnt >> 0);
+  *(response+2) = (uint8_t)(tx_cnt >> 8);
+  *(response+3) = (uint8_t)(rx_cnt >> 0);
+  *(response+4) = (uint8_t)(rx_cnt >> 8);
+  return (((4U + tx_num) << 16) | (5U + rx_cnt));
+}
+
+#endif  /* (DAP_UART != 0) */
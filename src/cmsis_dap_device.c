@@ -37,6 +37,30 @@ extern uint32_t SWO_GetTransportMode(void);
 //--------------------------------------------------------------------+
 // MACRO CONSTANT TYPEDEF
 //--------------------------------------------------------------------+
+// Packets are stored back to back in a byte ring per direction.
+#ifndef DAP_PACKET_ARENA_SIZE
+#define DAP_PACKET_ARENA_SIZE   (DAP_PACKET_COUNT * DAP_PACKET_SIZE)
+#endif
+TU_VERIFY_STATIC(DAP_PACKET_ARENA_SIZE >= DAP_PACKET_SIZE, "Arena must hold a packet of DAP_PACKET_SIZE");
+TU_VERIFY_STATIC(DAP_PACKET_ARENA_SIZE <= UINT16_MAX, "Arena offsets are 16 bits");
+
+#define ARENA_ALIGN(x)          (((x) + 3U) & ~3U)
+
+// SWO stream aggregation: a transfer starts once SWO_STREAM_BLOCK_SIZE
+// bytes are buffered, or SWO_STREAM_TIMEOUT ms after data became pending.
+#ifndef SWO_STREAM_BLOCK_SIZE
+#define SWO_STREAM_BLOCK_SIZE   512U
+#endif
+#ifndef SWO_STREAM_TIMEOUT
+#define SWO_STREAM_TIMEOUT      50U
+#endif
+
+// Trace buffer policy when full: 1 drops the oldest data, 0 drops the
+// newest data and reports an overrun.
+#ifndef SWO_BUFFER_OVERWRITE
+#define SWO_BUFFER_OVERWRITE    0
+#endif
+
 typedef struct
 {
   uint8_t itf_num;
@@ -46,30 +70,91 @@ typedef struct
   uint8_t ep_swo;
   #endif
 
+  uint16_t packet_size;   // DAP packet size on the current link
+
+  #if (SWO_STREAM != 0)
+  uint16_t swo_ep_size;
+  uint32_t swo_xfer_start;// trace ring index of the transfer in flight
+  uint32_t swo_xfer_len;  // bytes of the trace ring being transmitted
+  bool     swo_pending;   // swo_since is valid
+  uint32_t swo_since;     // time data became pending in ms
+  tud_cmsis_dap_swo_stats_t swo_stats;
+  #endif
+
+  #if (DAP_DUAL_CORE != 0)
+  uint8_t response_drop; // number of responses left over from before bus reset
+  #endif
+
+  /*------------- From this point, data is not cleared by bus reset -------------*/
+  // Single producer, single consumer rings.
+  // The request ring is filled by USB and drained by DAP_ExecuteCommand, and
+  // the response ring the other way around. In dual-core mode each index is
+  // written by one core only, so the rings are kept across bus reset.
   volatile uint8_t request_wp;
+  volatile uint8_t request_ready; // end of requests that can be executed
   volatile uint8_t request_rp;
   volatile uint8_t response_wp;
   volatile uint8_t response_rp;
+  #if (DAP_DUAL_CORE != 0)
+  // Requests before expire_end were received before bus reset and are not
+  // executed. USB bumps reset_seq after setting expire_end, and the executor
+  // copies it to expire_seq once it has passed expire_end.
+  volatile uint8_t expire_end;
+  volatile uint8_t reset_seq;
+  volatile uint8_t expire_seq;
+  #endif
 
-  /*------------- From this point, data is not cleared by bus reset -------------*/
+  uint16_t request_head;  // end of the newest request in the arena
+  uint16_t response_head; // end of the newest response in the arena
+  uint16_t epout_stage_sz;// received packet waiting for room in the arena
+
+  uint16_t epout_ofs[DAP_PACKET_COUNT];
   uint16_t epout_sz[DAP_PACKET_COUNT];
+  uint16_t epin_ofs[DAP_PACKET_COUNT];
   uint16_t epin_sz[DAP_PACKET_COUNT];
   #if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
-  tu_fifo_t swo_ff;
-  uint8_t swo_ff_buf[SWO_BUFFER_SIZE];
+  // Trace ring. The indices run freely and are masked on access, so the
+  // buffer can be as large as RAM allows.
+  volatile uint32_t swo_wr;
+  volatile uint32_t swo_rd;
+  bool     swo_overwrite; // drop the oldest data instead of the newest
   #endif
 
+  // Packet arena
+  TU_ATTR_ALIGNED(4) uint8_t request_arena[DAP_PACKET_ARENA_SIZE];
+  TU_ATTR_ALIGNED(4) uint8_t response_arena[DAP_PACKET_ARENA_SIZE];
+
   // Endpoint Transfer buffer
-  CFG_TUSB_MEM_ALIGN uint8_t epout_buf[DAP_PACKET_COUNT][DAP_PACKET_SIZE];
-  CFG_TUSB_MEM_ALIGN uint8_t epin_buf[DAP_PACKET_COUNT][DAP_PACKET_SIZE];
-  #if (SWO_STREAM != 0)
-  CFG_TUSB_MEM_ALIGN uint8_t epswo_buf[DAP_PACKET_SIZE];
-  #endif
+  CFG_TUSB_MEM_ALIGN uint8_t epout_buf[DAP_PACKET_SIZE];
+  CFG_TUSB_MEM_ALIGN uint8_t epin_buf[DAP_PACKET_SIZE];
 } cmsis_dap_interface_t;
 
 CFG_TUSB_MEM_SECTION static cmsis_dap_interface_t _cmsis_dap_itf[CFG_TUD_CMSIS_DAP];
 
-#define ITF_MEM_RESET_SIZE   offsetof(cmsis_dap_interface_t, epout_sz)
+#define ITF_MEM_RESET_SIZE   offsetof(cmsis_dap_interface_t, request_wp)
+
+#if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
+// Trace storage, kept out of the interface so that its alignment does not
+// pad the interface.
+#if (SWO_UART_DMA != 0)
+// DMA write ring must be aligned to its size
+CFG_TUSB_MEM_SECTION TU_ATTR_ALIGNED(SWO_BUFFER_SIZE) static uint8_t _cmsis_dap_swo_buf[CFG_TUD_CMSIS_DAP][SWO_BUFFER_SIZE];
+#else
+CFG_TUSB_MEM_SECTION CFG_TUSB_MEM_ALIGN static uint8_t _cmsis_dap_swo_buf[CFG_TUD_CMSIS_DAP][SWO_BUFFER_SIZE];
+#endif
+
+static inline uint8_t* swo_buf(cmsis_dap_interface_t const* p_itf)
+{
+  return _cmsis_dap_swo_buf[p_itf - _cmsis_dap_itf];
+}
+#endif
+
+#if (DAP_DUAL_CORE != 0)
+// Order buffer accesses against the index that hands them over to the other core.
+# define ring_barrier()    __DMB()
+#else
+# define ring_barrier()
+#endif
 
 //--------------------------------------------------------------------+
 // Weak stubs: invoked if no strong implementation is available
@@ -82,6 +167,10 @@ TU_ATTR_WEAK void tud_cmsis_dap_swo_write_cb(uint8_t intf) {
   (void) intf;
 }
 
+TU_ATTR_WEAK void tud_cmsis_dap_swo_overrun_cb(uint8_t intf) {
+  (void) intf;
+}
+
 //--------------------------------------------------------------------+
 // APPLICATION API
 //--------------------------------------------------------------------+
@@ -90,25 +179,90 @@ bool tud_cmsis_dap_n_mounted (uint8_t itf)
   return _cmsis_dap_itf[itf].ep_in && _cmsis_dap_itf[itf].ep_out;
 }
 
+uint32_t tud_cmsis_dap_n_packet_size(uint8_t itf)
+{
+  return _cmsis_dap_itf[itf].packet_size;
+}
+
+//--------------------------------------------------------------------+
+// Packet arena
+//--------------------------------------------------------------------+
+// Find contiguous room for size bytes.
+//   head:   end of the newest packet
+//   tail:   start of the oldest packet, or -1 if the arena is empty
+//   return: offset of the room, or -1 if there is none
+static int _arena_alloc(unsigned head, int tail, unsigned size)
+{
+  if (tail < 0) {
+    return (head + size <= DAP_PACKET_ARENA_SIZE) ? (int)head : 0;
+  }
+  if (head > (unsigned)tail) {
+    if (head + size <= DAP_PACKET_ARENA_SIZE) return (int)head;
+    if (size <= (unsigned)tail) return 0; // wrap around
+    return -1;
+  }
+  return (head + size <= (unsigned)tail) ? (int)head : -1;
+}
+
 //--------------------------------------------------------------------+
 // Read API
 //--------------------------------------------------------------------+
+// Move the received packet from the endpoint buffer into the request ring.
+//   return: false if it has to wait for room
+static bool _commit_request(cmsis_dap_interface_t* p_itf)
+{
+  unsigned size = p_itf->epout_stage_sz;
+  if (!size) return true;
+
+  uint8_t wp = p_itf->request_wp;
+  uint8_t rp = p_itf->request_rp;
+  if ((uint8_t)(wp - rp) >= DAP_PACKET_COUNT) return false;
+
+  int tail = (wp == rp) ? -1 : p_itf->epout_ofs[rp % DAP_PACKET_COUNT];
+  int ofs  = _arena_alloc(p_itf->request_head, tail, ARENA_ALIGN(size));
+  if (ofs < 0) {
+    // Queued packets that fill the arena are released as well, otherwise
+    // the packet that ends their batch could never be received.
+    ring_barrier();
+    p_itf->request_ready = wp;
+    return false;
+  }
+
+  uint8_t *p_req = &p_itf->request_arena[ofs];
+  memcpy(p_req, p_itf->epout_buf, size);
+  p_itf->epout_stage_sz = 0;
+  p_itf->request_head = (uint16_t)(ofs + ARENA_ALIGN(size));
+
+  unsigned idx = wp % DAP_PACKET_COUNT;
+  p_itf->epout_ofs[idx] = (uint16_t)ofs;
+  p_itf->epout_sz[idx]  = (uint16_t)size;
+  ++wp;
+  p_itf->request_wp = wp;
+  // Hold QueueCommands until a packet that is not queued arrives, then
+  // release the whole batch as ExecuteCommands.
+  // A ring filled up with queued packets is released as well since
+  // nothing else could arrive. The same holds for a full arena, see above.
+  if (ID_DAP_QueueCommands == p_req[0]) {
+    p_req[0] = ID_DAP_ExecuteCommands;
+    if ((uint8_t)(wp - rp) < DAP_PACKET_COUNT)
+      wp = p_itf->request_ready;
+  }
+  ring_barrier();
+  p_itf->request_ready = wp;
+  return true;
+}
+
 static void _prep_out_transaction(cmsis_dap_interface_t* p_itf)
 {
   uint8_t const rhport = 0;
 
+  // The endpoint buffer is reused once its packet is in the ring
+  if (!_commit_request(p_itf)) return;
+
   // claim endpoint
   TU_VERIFY(usbd_edpt_claim(rhport, p_itf->ep_out), );
 
-  uint8_t wp = p_itf->request_wp;
-
-  uint8_t occupancy = wp - p_itf->request_rp;
-  if (occupancy < DAP_PACKET_COUNT) {
-    unsigned idx = wp % DAP_PACKET_COUNT;
-    usbd_edpt_xfer(rhport, p_itf->ep_out, p_itf->epout_buf[idx], DAP_PACKET_SIZE);
-  } else {
-    usbd_edpt_release(rhport, p_itf->ep_out);
-  }
+  usbd_edpt_xfer(rhport, p_itf->ep_out, p_itf->epout_buf, p_itf->packet_size);
 }
 
 uint32_t tud_cmsis_dap_n_acquire_request_buffer(uint8_t itf, const uint8_t **pbuf)
@@ -116,44 +270,41 @@ uint32_t tud_cmsis_dap_n_acquire_request_buffer(uint8_t itf, const uint8_t **pbu
   TU_ASSERT(pbuf, 0);
   cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
 
+  // Queued commands become ready when the last packet of the batch arrives.
   uint8_t rp = p_itf->request_rp;
-  uint8_t wp = p_itf->request_wp;
-  if (wp == rp)
+  if (p_itf->request_ready == rp)
     return 0;
+  ring_barrier();
 
   unsigned idx = rp % DAP_PACKET_COUNT;
-  unsigned n = idx;
-  // Check if the last packet was received.
-  while ((wp != rp) &&
-         (p_itf->epout_buf[n][0] == ID_DAP_QueueCommands)) {
-    ++rp;
-    ++n;
-    if (n == DAP_PACKET_COUNT)
-      n = 0U;
-  }
-  if (wp == rp) // not received
-    return 0;
-
-  // Replace consecutive QueueCommands to ExecuteCommands
-  rp = p_itf->request_rp;
-  n = idx;
-  while ((wp != rp) &&
-         (p_itf->epout_buf[n][0] == ID_DAP_QueueCommands)) {
-    p_itf->epout_buf[n][0] = ID_DAP_ExecuteCommands;
-    ++rp;
-    ++n;
-    if (n == DAP_PACKET_COUNT)
-      n = 0U;
-  }
-  *pbuf = p_itf->epout_buf[idx];
+  *pbuf = &p_itf->request_arena[p_itf->epout_ofs[idx]];
   return p_itf->epout_sz[idx];
 }
 
+bool tud_cmsis_dap_n_request_expired(uint8_t itf)
+{
+#if (DAP_DUAL_CORE != 0)
+  cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
+  uint8_t seq = p_itf->reset_seq;
+  if (seq == p_itf->expire_seq) return false;
+  ring_barrier();
+  if (p_itf->request_rp != p_itf->expire_end) return true;
+  p_itf->expire_seq = seq;
+  return false;
+#else
+  (void) itf;
+  return false;
+#endif
+}
+
 void tud_cmsis_dap_n_release_request_buffer(uint8_t itf)
 {
   cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
+  ring_barrier();
   ++p_itf->request_rp;
+#if (DAP_DUAL_CORE == 0)
   _prep_out_transaction(p_itf);
+#endif
 }
 
 //--------------------------------------------------------------------+
@@ -167,10 +318,22 @@ static void maybe_transmit(cmsis_dap_interface_t* p_itf)
   TU_VERIFY( usbd_edpt_claim(rhport, p_itf->ep_in), );
 
   uint8_t rp = p_itf->response_rp;
+  uint8_t wp = p_itf->response_wp;
+
+#if (DAP_DUAL_CORE != 0)
+  // Skip responses to requests received before bus reset
+  while ((wp != rp) && p_itf->response_drop) {
+    --p_itf->response_drop;
+    p_itf->response_rp = ++rp;
+  }
+#endif
 
-  if (p_itf->response_wp != rp) {
+  if (wp != rp) {
+    ring_barrier();
     unsigned idx = rp % DAP_PACKET_COUNT;
-    usbd_edpt_xfer(rhport, p_itf->ep_in, p_itf->epin_buf[idx], p_itf->epin_sz[idx]);
+    unsigned size = p_itf->epin_sz[idx];
+    memcpy(p_itf->epin_buf, &p_itf->response_arena[p_itf->epin_ofs[idx]], size);
+    usbd_edpt_xfer(rhport, p_itf->ep_in, p_itf->epin_buf, size);
   } else {
     usbd_edpt_release(rhport, p_itf->ep_in);
   }
@@ -181,13 +344,21 @@ uint32_t tud_cmsis_dap_n_acquire_response_buffer(uint8_t itf, uint8_t **pbuf)
   TU_ASSERT(pbuf, 0);
   cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
 
-  uint8_t occupancy = p_itf->response_wp - p_itf->response_rp;
-  if (occupancy < DAP_PACKET_COUNT) {
-    unsigned idx = p_itf->response_wp % DAP_PACKET_COUNT;
-    *pbuf = p_itf->epin_buf[idx];
-    return DAP_PACKET_SIZE;
-  }
-  return 0;
+  // Reserve a whole packet. Only the actual size is kept on release.
+  uint8_t wp = p_itf->response_wp;
+  uint8_t rp = p_itf->response_rp;
+  if ((uint8_t)(wp - rp) >= DAP_PACKET_COUNT)
+    return 0;
+  ring_barrier();
+
+  int tail = (wp == rp) ? -1 : p_itf->epin_ofs[rp % DAP_PACKET_COUNT];
+  int ofs  = _arena_alloc(p_itf->response_head, tail, DAP_PACKET_SIZE);
+  if (ofs < 0)
+    return 0;
+
+  p_itf->epin_ofs[wp % DAP_PACKET_COUNT] = (uint16_t)ofs;
+  *pbuf = &p_itf->response_arena[ofs];
+  return DAP_PACKET_SIZE;
 }
 
 void tud_cmsis_dap_n_release_response_buffer(uint8_t itf, uint32_t bufsize)
@@ -195,45 +366,175 @@ void tud_cmsis_dap_n_release_response_buffer(uint8_t itf, uint32_t bufsize)
   cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
   unsigned idx = p_itf->response_wp % DAP_PACKET_COUNT;
   p_itf->epin_sz[idx] = bufsize;
+  p_itf->response_head = (uint16_t)(p_itf->epin_ofs[idx] + ARENA_ALIGN(bufsize));
+  ring_barrier();
   ++p_itf->response_wp;
+#if (DAP_DUAL_CORE == 0)
   maybe_transmit(p_itf);
+#endif
 }
 
+#if (DAP_DUAL_CORE != 0)
+void tud_cmsis_dap_n_task(uint8_t itf)
+{
+  cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
+  if (!tud_cmsis_dap_n_mounted(itf)) return;
+  _prep_out_transaction(p_itf);
+  maybe_transmit(p_itf);
+}
+#endif
+
 #if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
 //--------------------------------------------------------------------+
 // SWO API
 //--------------------------------------------------------------------+
+TU_VERIFY_STATIC((SWO_BUFFER_SIZE & (SWO_BUFFER_SIZE - 1)) == 0, "SWO_BUFFER_SIZE must be 2^n");
+
+#define SWO_MASK  (SWO_BUFFER_SIZE - 1U)
+
+static inline uint32_t swo_used(cmsis_dap_interface_t const* p_itf)
+{
+  return p_itf->swo_wr - p_itf->swo_rd;
+}
+
+// Bytes that can be written without touching data being transmitted.
+// Unread data is only overwritten with swo_overwrite set.
+static uint32_t swo_writable(cmsis_dap_interface_t const* p_itf)
+{
+#if (SWO_STREAM != 0)
+  if (p_itf->swo_xfer_len) {
+    // The endpoint reads from the buffer until the transfer completes
+    return p_itf->swo_xfer_start + SWO_BUFFER_SIZE - p_itf->swo_wr;
+  }
+#endif
+  return p_itf->swo_overwrite ? SWO_BUFFER_SIZE : (SWO_BUFFER_SIZE - swo_used(p_itf));
+}
+
+// Advance the write index, dropping the oldest data to make room
+static void swo_advance_write(cmsis_dap_interface_t* p_itf, uint32_t len)
+{
+  uint32_t wr = p_itf->swo_wr + len;
+  if ((wr - p_itf->swo_rd) > SWO_BUFFER_SIZE) {
+    p_itf->swo_rd = wr - SWO_BUFFER_SIZE;
+  }
+  p_itf->swo_wr = wr;
+}
+
 #if (SWO_STREAM != 0)
-static void maybe_transmit_swo(cmsis_dap_interface_t* p_itf)
+static void maybe_transmit_swo(cmsis_dap_interface_t* p_itf, bool flush)
 {
   if (2 != SWO_GetTransportMode()) return;
 
   const uint8_t rhport = 0;
+  const uint32_t count = swo_used(p_itf);
+
+  // Wait for a full block unless the timeout has expired
+  if (!flush && (count < SWO_STREAM_BLOCK_SIZE)) return;
 
   // Claim the endpoint
   TU_VERIFY(usbd_edpt_claim(rhport, p_itf->ep_swo), );
 
-  // Pull data from FIFO
-  const uint16_t count = tu_fifo_read_n(&p_itf->swo_ff, p_itf->epswo_buf, DAP_PACKET_SIZE);
-
-  if (count) {
-    TU_ASSERT(usbd_edpt_xfer(rhport, p_itf->ep_swo, p_itf->epswo_buf, count), );
+  // Transmit straight from the ring. The data stays in the ring until the
+  // transfer completes, so the part up to the end of the buffer is sent and
+  // the part wrapped around follows in the next transfer.
+  const uint32_t rd  = p_itf->swo_rd;
+  const uint32_t len = TU_MIN(TU_MIN(count, SWO_BUFFER_SIZE - (rd & SWO_MASK)), SWO_STREAM_BLOCK_SIZE);
+
+  if (len) {
+    p_itf->swo_xfer_start = rd;
+    p_itf->swo_xfer_len   = len;
+    p_itf->swo_pending    = false;
+    p_itf->swo_stats.bytes     += len;
+    p_itf->swo_stats.transfers += 1;
+    p_itf->swo_stats.packets   += (len + p_itf->swo_ep_size - 1) / p_itf->swo_ep_size;
+    TU_ASSERT(usbd_edpt_xfer(rhport, p_itf->ep_swo, &swo_buf(p_itf)[rd & SWO_MASK], (uint16_t)len), );
   } else {
     // Release endpoint since we don't make any transfer
     // Note: data is dropped if terminal is not connected
     usbd_edpt_release(rhport, p_itf->ep_swo);
   }
 }
+
+void tud_cmsis_dap_n_swo_task(uint8_t itf, uint32_t now_ms)
+{
+  cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
+  if (!p_itf->ep_swo) return;
+
+  if (!swo_used(p_itf)) {
+    p_itf->swo_pending = false;
+  } else if (!p_itf->swo_pending) {
+    p_itf->swo_pending = true;
+    p_itf->swo_since   = now_ms;
+  } else if ((now_ms - p_itf->swo_since) >= SWO_STREAM_TIMEOUT) {
+    maybe_transmit_swo(p_itf, true);
+  }
+}
+
+void tud_cmsis_dap_n_swo_stats(uint8_t itf, tud_cmsis_dap_swo_stats_t *stats)
+{
+  *stats = _cmsis_dap_itf[itf].swo_stats;
+}
 #else
-# define maybe_transmit_swo(p_itf)
+# define maybe_transmit_swo(p_itf, flush)
 #endif
 
 uint32_t tud_cmsis_dap_n_swo_enqueue(uint8_t itf, void const *data, uint32_t len)
 {
   cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
-  uint16_t ret = tu_fifo_write_n(&p_itf->swo_ff, data, (uint16_t)TU_MIN(len, UINT16_MAX));
-  maybe_transmit_swo(p_itf);
-  return ret;
+  const uint8_t *src = (const uint8_t *)data;
+  uint32_t count = TU_MIN(len, swo_writable(p_itf));
+
+  if (count < len) {
+    // Keep the newest part of the data when dropping the oldest
+    if (p_itf->swo_overwrite) src += len - count;
+    tud_cmsis_dap_swo_overrun_cb(itf);
+  }
+
+  const uint32_t ofs = p_itf->swo_wr & SWO_MASK;
+  const uint32_t lin = TU_MIN(count, SWO_BUFFER_SIZE - ofs);
+  memcpy(&swo_buf(p_itf)[ofs], src, lin);
+  memcpy(swo_buf(p_itf), src + lin, count - lin);
+  swo_advance_write(p_itf, count);
+
+  maybe_transmit_swo(p_itf, false);
+  return count;
+}
+
+void tud_cmsis_dap_n_swo_set_overwrite(uint8_t itf, bool overwrite)
+{
+  _cmsis_dap_itf[itf].swo_overwrite = overwrite;
+}
+
+uint32_t tud_cmsis_dap_n_swo_buffer(uint8_t itf, uint8_t **pbuf)
+{
+  TU_ASSERT(pbuf, 0);
+  *pbuf = _cmsis_dap_swo_buf[itf];
+  return SWO_BUFFER_SIZE;
+}
+
+uint32_t tud_cmsis_dap_n_swo_commit(uint8_t itf, uint32_t len)
+{
+  cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
+
+  // The writer does not wait, so data past the limit is overwritten already
+  const bool overrun = (len > swo_writable(p_itf));
+  if (!overrun) {
+    swo_advance_write(p_itf, len);
+    maybe_transmit_swo(p_itf, false);
+    return len;
+  }
+
+  tud_cmsis_dap_swo_overrun_cb(itf);
+  if (p_itf->swo_overwrite) {
+    // The newest SWO_BUFFER_SIZE bytes are intact unless a transfer
+    // was reading them.
+    swo_advance_write(p_itf, len);
+    return len;
+  }
+  // Drop it all and carry on from where the writer is now.
+  p_itf->swo_wr += len;
+  p_itf->swo_rd  = p_itf->swo_wr;
+  return 0;
 }
 
 uint32_t tud_cmsis_dap_n_swo_dequeue(uint8_t itf, void* buffer, uint32_t bufsize)
@@ -241,26 +542,36 @@ uint32_t tud_cmsis_dap_n_swo_dequeue(uint8_t itf, void* buffer, uint32_t bufsize
   if (1 != SWO_GetTransportMode()) return 0;
 
   cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
-  const uint16_t count = tu_fifo_read_n(&p_itf->swo_ff, buffer, bufsize);
+  uint8_t *dst = (uint8_t *)buffer;
+  const uint32_t rd    = p_itf->swo_rd;
+  const uint32_t count = TU_MIN(bufsize, p_itf->swo_wr - rd);
+  const uint32_t ofs   = rd & SWO_MASK;
+  const uint32_t lin   = TU_MIN(count, SWO_BUFFER_SIZE - ofs);
+  memcpy(dst, &swo_buf(p_itf)[ofs], lin);
+  memcpy(dst + lin, swo_buf(p_itf), count - lin);
+  p_itf->swo_rd = rd + count;
   return count;
 }
 
 uint32_t tud_cmsis_dap_n_swo_free(uint8_t itf)
 {
   cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
-  return tu_fifo_remaining(&p_itf->swo_ff);
+  return SWO_BUFFER_SIZE - swo_used(p_itf);
 }
 
 uint32_t tud_cmsis_dap_n_swo_used(uint8_t itf)
 {
   cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
-  return tu_fifo_count(&p_itf->swo_ff);
+  return swo_used(p_itf);
 }
 
 uint32_t tud_cmsis_dap_n_swo_clear(uint8_t itf)
 {
   cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[itf];
-  return tu_fifo_clear(&p_itf->swo_ff);
+  // The write index stays where a capture engine writing the buffer is.
+  // A transfer in flight keeps its data until it completes.
+  p_itf->swo_rd = p_itf->swo_wr;
+  return 1;
 }
 
 #endif
@@ -273,8 +584,7 @@ void cmsis_dapd_init(void)
   tu_memclr(_cmsis_dap_itf, sizeof(_cmsis_dap_itf));
 #if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
   for(uint_fast8_t i = 0; i < CFG_TUD_CMSIS_DAP; i++) {
-    cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[i];
-    tu_fifo_config(&p_itf->swo_ff, p_itf->swo_ff_buf, TU_ARRAY_SIZE(p_itf->swo_ff_buf), 1, true);
+    _cmsis_dap_itf[i].swo_overwrite = (SWO_BUFFER_OVERWRITE != 0);
   }
 #endif
 }
@@ -293,9 +603,31 @@ void cmsis_dapd_reset(uint8_t rhport)
     cmsis_dap_interface_t* p_itf = &_cmsis_dap_itf[i];
 
     tu_memclr(p_itf, ITF_MEM_RESET_SIZE);
+#if (DAP_DUAL_CORE != 0)
+    // The executor may be in the middle of a request. Keep the rings going
+    // and drop the responses to everything received so far instead. The
+    // requests that have not started are skipped, including a batch of
+    // queued commands that is still held.
+    uint8_t wp = p_itf->request_wp;
+    p_itf->response_drop = wp - p_itf->response_rp;
+    p_itf->epout_stage_sz = 0;
+    p_itf->expire_end = wp;
+    ring_barrier();
+    ++p_itf->reset_seq;
+    ring_barrier();
+    p_itf->request_ready = wp;
+#else
+    p_itf->request_wp    = 0;
+    p_itf->request_ready = 0;
+    p_itf->request_rp    = 0;
+    p_itf->response_wp = 0;
+    p_itf->response_rp = 0;
+    p_itf->request_head   = 0;
+    p_itf->response_head  = 0;
+    p_itf->epout_stage_sz = 0;
+#endif
 #if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
-    tu_fifo_clear(&p_itf->swo_ff);
-    tu_fifo_set_overwritable(&p_itf->swo_ff, true);
+    p_itf->swo_rd = p_itf->swo_wr;
 #endif
   }
 }
@@ -328,6 +660,11 @@ uint16_t cmsis_dapd_open(uint8_t rhport, tusb_desc_interface_t const * desc_itf,
       p_desc = tu_desc_next(p_desc);
     }
 
+    // Full speed bulk endpoints carry 64 byte DAP packets. Larger packets
+    // need a high speed link.
+    uint16_t const ep_size = tu_edpt_packet_size((tusb_desc_endpoint_t const *) p_desc);
+    p_cmsis_dap->packet_size = (ep_size < 512) ? TU_MIN(DAP_PACKET_SIZE, 64) : DAP_PACKET_SIZE;
+
     // Open endpoint pair with usbd helper
     TU_ASSERT(usbd_open_edpt_pair(rhport, p_desc, 2, TUSB_XFER_BULK, &p_cmsis_dap->ep_out, &p_cmsis_dap->ep_in), 0);
 
@@ -336,6 +673,7 @@ uint16_t cmsis_dapd_open(uint8_t rhport, tusb_desc_interface_t const * desc_itf,
   #if (SWO_STREAM != 0)
     if (desc_itf->bNumEndpoints == 3)
     {
+      p_cmsis_dap->swo_ep_size = tu_edpt_packet_size((tusb_desc_endpoint_t const *) p_desc);
       TU_ASSERT(usbd_open_edpt_pair(rhport, p_desc, 1, TUSB_XFER_BULK, NULL, &p_cmsis_dap->ep_swo), 0);
       p_desc += sizeof(tusb_desc_endpoint_t);
     }
@@ -344,7 +682,7 @@ uint16_t cmsis_dapd_open(uint8_t rhport, tusb_desc_interface_t const * desc_itf,
     // Prepare for incoming data
     if ( p_cmsis_dap->ep_out )
     {
-      TU_ASSERT(usbd_edpt_xfer(rhport, p_cmsis_dap->ep_out, p_cmsis_dap->epout_buf[0], sizeof(p_cmsis_dap->epout_buf)), 0);
+      TU_ASSERT(usbd_edpt_xfer(rhport, p_cmsis_dap->ep_out, p_cmsis_dap->epout_buf, p_cmsis_dap->packet_size), 0);
     }
 
     if ( p_cmsis_dap->ep_in ) maybe_transmit(p_cmsis_dap);
@@ -376,12 +714,10 @@ bool cmsis_dapd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, u
   if ( ep_addr == p_itf->ep_out )
   {
     if (xferred_bytes) {
-      unsigned idx = p_itf->request_wp % DAP_PACKET_COUNT;
-      p_itf->epout_sz[idx] = xferred_bytes;
-      if (ID_DAP_TransferAbort == p_itf->epout_buf[idx][0]) {
+      if (ID_DAP_TransferAbort == p_itf->epout_buf[0]) {
         tud_cmsis_dap_transfer_abort_cb(itf);
       } else {
-        ++p_itf->request_wp;
+        p_itf->epout_stage_sz = (uint16_t)xferred_bytes;
       }
     }
     _prep_out_transaction(p_itf);
@@ -395,8 +731,13 @@ bool cmsis_dapd_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, u
 #if (SWO_STREAM != 0)
   else if ( ep_addr == p_itf->ep_swo )
   {
+    // Free the data sent. Nothing is left to free if it was cleared or
+    // dropped meanwhile.
+    const uint32_t end = p_itf->swo_xfer_start + TU_MIN(xferred_bytes, p_itf->swo_xfer_len);
+    if ((int32_t)(end - p_itf->swo_rd) > 0) p_itf->swo_rd = end;
+    p_itf->swo_xfer_len = 0;
     // try to send more if possible
-    maybe_transmit_swo(p_itf);
+    maybe_transmit_swo(p_itf, false);
   }
 #endif
 
@@ -30,33 +30,58 @@
  extern "C" {
 #endif
 
+// SWO stream counters since bus reset.
+// bytes / packets is the payload achieved per USB transaction.
+typedef struct
+{
+  uint32_t bytes;
+  uint32_t transfers;
+  uint32_t packets;
+} tud_cmsis_dap_swo_stats_t;
+
 //--------------------------------------------------------------------+
 // Application API (Multiple Interfaces)
 //--------------------------------------------------------------------+
 bool     tud_cmsis_dap_n_mounted         (uint8_t itf);
+uint32_t tud_cmsis_dap_n_packet_size(uint8_t itf);
 uint32_t tud_cmsis_dap_n_acquire_request_buffer(uint8_t itf, const uint8_t **pbuf);
+bool     tud_cmsis_dap_n_request_expired(uint8_t itf);
 void     tud_cmsis_dap_n_release_request_buffer(uint8_t itf);
 uint32_t tud_cmsis_dap_n_acquire_response_buffer(uint8_t itf, uint8_t **pbuf);
 void     tud_cmsis_dap_n_release_response_buffer(uint8_t itf, uint32_t bufsize);
 uint32_t tud_cmsis_dap_n_swo_enqueue(uint8_t itf, void const *data, uint32_t len);
+void     tud_cmsis_dap_n_swo_set_overwrite(uint8_t itf, bool overwrite);
+uint32_t tud_cmsis_dap_n_swo_buffer(uint8_t itf, uint8_t **pbuf);
+uint32_t tud_cmsis_dap_n_swo_commit(uint8_t itf, uint32_t len);
 uint32_t tud_cmsis_dap_n_swo_dequeue(uint8_t itf, void* buffer, uint32_t bufsize);
 uint32_t tud_cmsis_dap_n_swo_free(uint8_t itf);
 uint32_t tud_cmsis_dap_n_swo_used(uint8_t itf);
 uint32_t tud_cmsis_dap_n_swo_clear(uint8_t itf);
+void     tud_cmsis_dap_n_swo_task(uint8_t itf, uint32_t now_ms);
+void     tud_cmsis_dap_n_swo_stats(uint8_t itf, tud_cmsis_dap_swo_stats_t *stats);
+void     tud_cmsis_dap_n_task(uint8_t itf);
 
 //--------------------------------------------------------------------+
 // Application API (Single Port)
 //--------------------------------------------------------------------+
 static inline bool     tud_cmsis_dap_mounted         (void);
+static inline uint32_t tud_cmsis_dap_packet_size(void);
 static inline uint32_t tud_cmsis_dap_acquire_request_buffer(const uint8_t **pbuf);
+static inline bool     tud_cmsis_dap_request_expired(void);
 static inline void     tud_cmsis_dap_release_request_buffer(void);
 static inline uint32_t tud_cmsis_dap_acquire_response_buffer(uint8_t **pbuf);
 static inline void     tud_cmsis_dap_release_response_buffer(uint32_t bufsize);
-static inline bool     tud_cmsis_dap_swo_enqueue(void const *data, uint16_t len);
+static inline uint32_t tud_cmsis_dap_swo_enqueue(void const *data, uint32_t len);
+static inline void     tud_cmsis_dap_swo_set_overwrite(bool overwrite);
+static inline uint32_t tud_cmsis_dap_swo_buffer(uint8_t **pbuf);
+static inline uint32_t tud_cmsis_dap_swo_commit(uint32_t len);
 static inline uint32_t tud_cmsis_dap_swo_dequeue(void* buffer, uint32_t bufsize);
 static inline uint32_t tud_cmsis_dap_swo_free(void);
 static inline uint32_t tud_cmsis_dap_swo_used(void);
 static inline uint32_t tud_cmsis_dap_swo_clear(void);
+static inline void     tud_cmsis_dap_swo_task(uint32_t now_ms);
+static inline void     tud_cmsis_dap_swo_stats(tud_cmsis_dap_swo_stats_t *stats);
+static inline void     tud_cmsis_dap_task(void);
 
 //--------------------------------------------------------------------+
 // Application Callback API (weak is optional)
@@ -65,6 +90,9 @@ static inline uint32_t tud_cmsis_dap_swo_clear(void);
 // Invoked when abort request is received
 void tud_cmsis_dap_transfer_abort_cb(uint8_t itf);
 
+// Invoked when trace data is lost because the trace buffer is full
+void tud_cmsis_dap_swo_overrun_cb(uint8_t itf);
+
 //--------------------------------------------------------------------+
 // Inline Functions
 //--------------------------------------------------------------------+
@@ -74,11 +102,23 @@ static inline bool tud_cmsis_dap_mounted (void)
   return tud_cmsis_dap_n_mounted(0);
 }
 
+// DAP packet size chosen for the link speed at enumeration
+static inline uint32_t tud_cmsis_dap_packet_size(void)
+{
+  return tud_cmsis_dap_n_packet_size(0);
+}
+
 static inline uint32_t tud_cmsis_dap_acquire_request_buffer(const uint8_t **pbuf)
 {
   return tud_cmsis_dap_n_acquire_request_buffer(0, pbuf);
 }
 
+// Check if the acquired request was received before bus reset (DAP_DUAL_CORE only)
+static inline bool tud_cmsis_dap_request_expired(void)
+{
+  return tud_cmsis_dap_n_request_expired(0);
+}
+
 static inline void tud_cmsis_dap_release_request_buffer(void)
 {
   tud_cmsis_dap_n_release_request_buffer(0);
@@ -94,11 +134,32 @@ static inline void tud_cmsis_dap_release_response_buffer(uint32_t bufsize)
   tud_cmsis_dap_n_release_response_buffer(0, bufsize);
 }
 
-static inline bool tud_cmsis_dap_swo_enqueue(void const *data, uint16_t len)
+// Append trace data. Returns the number of bytes stored.
+static inline uint32_t tud_cmsis_dap_swo_enqueue(void const *data, uint32_t len)
 {
   return tud_cmsis_dap_n_swo_enqueue(0, data, len);
 }
 
+// Choose what a full trace buffer drops: the oldest data if overwrite is
+// set, otherwise the newest data, which is reported as an overrun.
+static inline void tud_cmsis_dap_swo_set_overwrite(bool overwrite)
+{
+  tud_cmsis_dap_n_swo_set_overwrite(0, overwrite);
+}
+
+// Trace buffer storage for a capture engine writing it directly
+static inline uint32_t tud_cmsis_dap_swo_buffer(uint8_t **pbuf)
+{
+  return tud_cmsis_dap_n_swo_buffer(0, pbuf);
+}
+
+// Append len bytes written directly into the trace buffer storage.
+// Returns 0 if unread data was overwritten and the buffer was emptied.
+static inline uint32_t tud_cmsis_dap_swo_commit(uint32_t len)
+{
+  return tud_cmsis_dap_n_swo_commit(0, len);
+}
+
 static inline uint32_t tud_cmsis_dap_swo_dequeue(void* buffer, uint32_t bufsize)
 {
   return tud_cmsis_dap_n_swo_dequeue(0, buffer, bufsize);
@@ -118,6 +179,23 @@ static inline uint32_t tud_cmsis_dap_swo_clear(void)
   return tud_cmsis_dap_n_swo_clear(0);
 }
 
+// Flush a partial SWO stream block once SWO_STREAM_TIMEOUT has expired
+static inline void tud_cmsis_dap_swo_task(uint32_t now_ms)
+{
+  tud_cmsis_dap_n_swo_task(0, now_ms);
+}
+
+static inline void tud_cmsis_dap_swo_stats(tud_cmsis_dap_swo_stats_t *stats)
+{
+  tud_cmsis_dap_n_swo_stats(0, stats);
+}
+
+// Start USB transfers for buffers released by the other core (DAP_DUAL_CORE only)
+static inline void tud_cmsis_dap_task(void)
+{
+  tud_cmsis_dap_n_task(0);
+}
+
 //--------------------------------------------------------------------+
 // Internal Class Driver API
 //--------------------------------------------------------------------+
@@ -0,0 +1,96 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#include "cmsis_dap_device.h"
+#include "dap_executor.h"
+
+#include "DAP_config.h"
+#include "DAP.h"
+
+#if defined(DEBUG) && (DAP_DUAL_CORE == 0)
+#define TRACE_COMMANDS
+void cdc_printf(const char* str, ...);
+#endif
+
+// DAP_ProcessCommand, reporting the packet size of the current link in
+// DAP_Info. DAP.c reports DAP_PACKET_SIZE, the largest size buffers are
+// built for.
+static uint32_t process_command(const uint8_t *request, uint8_t *response)
+{
+  uint32_t num = DAP_ProcessCommand(request, response);
+  if ((request[0] == ID_DAP_Info) && (request[1] == DAP_ID_PACKET_SIZE) && (response[1] == 2U)) {
+    uint32_t size = tud_cmsis_dap_packet_size();
+    response[2] = (uint8_t)(size >> 0);
+    response[3] = (uint8_t)(size >> 8);
+  }
+  return num;
+}
+
+// DAP_ExecuteCommand, running the commands of a batch through
+// process_command so that every reply path reports the same packet size.
+static uint32_t execute_command(const uint8_t *request, uint8_t *response)
+{
+  if (request[0] != ID_DAP_ExecuteCommands) {
+    return process_command(request, response);
+  }
+
+  uint32_t cnt = request[1];
+  uint32_t num = (2U << 16) | 2U;
+  response[0] = request[0];
+  response[1] = (uint8_t)cnt;
+  request  += 2;
+  response += 2;
+  while (cnt--) {
+    uint32_t n = process_command(request, response);
+    num += n;
+    request  += (uint16_t)(n >> 16);
+    response += (uint16_t)n;
+  }
+  return num;
+}
+
+uint32_t dap_execute_requests(uint32_t budget)
+{
+  uint32_t count;
+
+  for (count = 0; count < budget; ++count) {
+    const uint8_t *p_req;
+    uint8_t *p_rsp;
+    unsigned sz_req = tud_cmsis_dap_acquire_request_buffer(&p_req);
+    if (!sz_req) break;
+    unsigned sz_rsp = tud_cmsis_dap_acquire_response_buffer(&p_rsp);
+    if (!sz_rsp) break;
+
+    uint32_t result = 0;
+    // The response to a request from before bus reset is dropped anyway
+    if (!tud_cmsis_dap_request_expired()) {
+      result = execute_command(p_req, p_rsp);
+    }
+#ifdef TRACE_COMMANDS
+    cdc_printf("%x %x -> %lx %x\n", p_req[0], sz_req, result, p_rsp[1]);
+#endif
+
+    tud_cmsis_dap_release_request_buffer();
+    tud_cmsis_dap_release_response_buffer(result & 0xFFFFU);
+  }
+  return count;
+}
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#ifndef _DAP_EXECUTOR_H_
+#define _DAP_EXECUTOR_H_
+
+#include <stdint.h>
+
+// Trace executed commands on the CDC port, which then no longer bridges the
+// UART. The trace is only printed in single-core builds, since cdc_printf
+// must run on the core that services USB.
+//#define DEBUG
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+// Execute received requests while response buffers are available.
+// Stops at a QueueCommands chain whose last packet has not arrived yet.
+//   budget: maximum number of requests to execute
+//   return: number of executed requests
+uint32_t dap_execute_requests(uint32_t budget);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _DAP_EXECUTOR_H_ */
@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#include <stddef.h>
+
+#include "flash_runner.h"
+
+enum {
+  STATE_NONE = 0,   // no algorithm
+  STATE_SETUP,      // algorithm set up, Init not called
+  STATE_READY,      // initialized, target halted
+  STATE_BUSY,       // ProgramPage running
+};
+
+#define XPSR_T              (1UL << 24)
+
+// Start func(a0, a1, a2) on the halted core.
+static uint32_t start_call(flash_runner_t* r, uint32_t func, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+  const flash_target_t* t = r->target;
+  const struct {
+    uint32_t reg;
+    uint32_t value;
+  } regs[] = {
+    {FLASH_REG_R0 + 0U, a0},
+    {FLASH_REG_R0 + 1U, a1},
+    {FLASH_REG_R0 + 2U, a2},
+    {FLASH_REG_R9,      r->algo.static_base},
+    {FLASH_REG_SP,      r->algo.stack_pointer},
+    {FLASH_REG_LR,      r->algo.breakpoint | 1U},
+    {FLASH_REG_PC,      func & ~1U},
+    {FLASH_REG_XPSR,    XPSR_T},
+  };
+
+  for (size_t i = 0; i < sizeof(regs) / sizeof(regs[0]); ++i) {
+    if (!t->write_reg(t->ctx, regs[i].reg, regs[i].value)) return FLASH_RUNNER_ERR_TARGET;
+  }
+  r->started = t->millis(t->ctx);
+  if (!t->resume(t->ctx)) return FLASH_RUNNER_ERR_TARGET;
+  return FLASH_RUNNER_OK;
+}
+
+// Wait until the running function hits the breakpoint.
+static uint32_t wait_call(flash_runner_t* r)
+{
+  const flash_target_t* t = r->target;
+  bool halted = false;
+
+  while (!halted) {
+    if (!t->halted(t->ctx, &halted)) return FLASH_RUNNER_ERR_TARGET;
+    if (!halted && ((t->millis(t->ctx) - r->started) > r->algo.timeout_ms))
+      return FLASH_RUNNER_ERR_TIMEOUT;
+  }
+  if (!t->read_reg(t->ctx, FLASH_REG_R0, &r->result)) return FLASH_RUNNER_ERR_TARGET;
+  return r->result ? FLASH_RUNNER_ERR_ALGO : FLASH_RUNNER_OK;
+}
+
+// A failed call leaves the core in an unknown state; Init must be called again.
+static uint32_t finish(flash_runner_t* r, uint32_t status)
+{
+  if (status != FLASH_RUNNER_OK) {
+    r->state = STATE_SETUP;
+    r->fill  = 0U;
+  }
+  return status;
+}
+
+static uint32_t wait_idle(flash_runner_t* r)
+{
+  if (r->state != STATE_BUSY) return FLASH_RUNNER_OK;
+  r->state = STATE_READY;
+  return wait_call(r);
+}
+
+static uint32_t call(flash_runner_t* r, uint32_t func, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+  uint32_t status = start_call(r, func, a0, a1, a2);
+  if (status == FLASH_RUNNER_OK) status = wait_call(r);
+  return status;
+}
+
+// Start ProgramPage on the active buffer and switch to the other one.
+static uint32_t program_active(flash_runner_t* r)
+{
+  uint32_t status = wait_idle(r);
+  if (status != FLASH_RUNNER_OK) return status;
+
+  status = start_call(r, r->algo.pc_program_page, r->page_addr, r->fill, r->algo.buffer[r->active]);
+  if (status != FLASH_RUNNER_OK) return status;
+  r->state      = STATE_BUSY;
+  r->active    ^= 1U;
+  r->page_addr += r->fill;
+  r->fill       = 0U;
+  return FLASH_RUNNER_OK;
+}
+
+uint32_t flash_runner_setup(flash_runner_t* r, const flash_target_t* target, const flash_algo_t* algo)
+{
+  r->state = STATE_NONE;
+  if (!algo->page_size || (algo->buffer[0] == algo->buffer[1])) return FLASH_RUNNER_ERR_PARAM;
+  r->target    = target;
+  r->algo      = *algo;
+  r->state     = STATE_SETUP;
+  r->active    = 0U;
+  r->fill      = 0U;
+  r->page_addr = 0U;
+  r->result    = 0U;
+  return FLASH_RUNNER_OK;
+}
+
+uint32_t flash_runner_init(flash_runner_t* r, uint32_t addr, uint32_t clk, uint32_t fnc)
+{
+  if (r->state == STATE_NONE) return FLASH_RUNNER_ERR_STATE;
+  r->state = STATE_SETUP;
+  r->fill  = 0U;
+  uint32_t status = call(r, r->algo.pc_init, addr, clk, fnc);
+  if (status == FLASH_RUNNER_OK) r->state = STATE_READY;
+  return status;
+}
+
+uint32_t flash_runner_uninit(flash_runner_t* r, uint32_t fnc)
+{
+  uint32_t status = flash_runner_flush(r);
+  if (status != FLASH_RUNNER_OK) return status;
+  status = call(r, r->algo.pc_uninit, fnc, 0U, 0U);
+  r->state = STATE_SETUP;
+  return status;
+}
+
+uint32_t flash_runner_erase(flash_runner_t* r, uint32_t addr)
+{
+  uint32_t status = flash_runner_flush(r);
+  if (status != FLASH_RUNNER_OK) return status;
+  return finish(r, call(r, r->algo.pc_erase_sector, addr, 0U, 0U));
+}
+
+uint32_t flash_runner_write(flash_runner_t* r, uint32_t addr, const uint8_t* data, uint32_t len)
+{
+  const flash_target_t* t = r->target;
+  uint32_t status;
+
+  if (r->state < STATE_READY) return FLASH_RUNNER_ERR_STATE;
+  if (r->fill && (addr != (r->page_addr + r->fill))) {
+    status = program_active(r);
+    if (status != FLASH_RUNNER_OK) return finish(r, status);
+  }
+  if (!r->fill) r->page_addr = addr;
+
+  while (len) {
+    uint32_t n = r->algo.page_size - r->fill;
+    if (n > len) n = len;
+    // The target may be running ProgramPage on the other buffer
+    if (!t->write_mem(t->ctx, r->algo.buffer[r->active] + r->fill, data, n))
+      return finish(r, FLASH_RUNNER_ERR_TARGET);
+    r->fill += n;
+    data    += n;
+    len     -= n;
+    if (r->fill == r->algo.page_size) {
+      status = program_active(r);
+      if (status != FLASH_RUNNER_OK) return finish(r, status);
+    }
+  }
+  return FLASH_RUNNER_OK;
+}
+
+uint32_t flash_runner_flush(flash_runner_t* r)
+{
+  uint32_t status;
+
+  if (r->state < STATE_READY) return FLASH_RUNNER_ERR_STATE;
+  if (r->fill) {
+    status = program_active(r);
+    if (status != FLASH_RUNNER_OK) return finish(r, status);
+  }
+  return finish(r, wait_idle(r));
+}
@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#ifndef _FLASH_RUNNER_H_
+#define _FLASH_RUNNER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Flash algorithm runner
+//--------------------------------------------------------------------+
+// Runs the functions of a CMSIS flash algorithm that the host has loaded
+// into target RAM. Page data is streamed into one of two page buffers
+// while the target programs the page in the other one.
+// Target access goes through flash_target_t, so the runner does not depend
+// on the debug port and can run against a simulated target.
+
+// Status codes
+#define FLASH_RUNNER_OK             0U
+#define FLASH_RUNNER_ERR_TARGET     1U  // debug access failed
+#define FLASH_RUNNER_ERR_TIMEOUT    2U  // function did not return in time
+#define FLASH_RUNNER_ERR_ALGO       3U  // function returned non-zero
+#define FLASH_RUNNER_ERR_STATE      4U  // no algorithm or not initialized
+#define FLASH_RUNNER_ERR_PARAM      5U  // bad descriptor or address
+
+// Core register numbers for DCRSR
+#define FLASH_REG_R0                0U
+#define FLASH_REG_R9                9U
+#define FLASH_REG_SP                13U
+#define FLASH_REG_LR                14U
+#define FLASH_REG_PC                15U
+#define FLASH_REG_XPSR              16U
+
+typedef struct {
+  void* ctx;
+  bool     (*write_mem)(void* ctx, uint32_t addr, const uint8_t* data, uint32_t len);
+  bool     (*write_reg)(void* ctx, uint32_t reg, uint32_t value);
+  bool     (*read_reg)(void* ctx, uint32_t reg, uint32_t* value);
+  bool     (*resume)(void* ctx);              // run the halted core
+  bool     (*halted)(void* ctx, bool* halted);
+  uint32_t (*millis)(void* ctx);
+} flash_target_t;
+
+// Flash algorithm descriptor
+typedef struct {
+  uint32_t breakpoint;      // address of a BKPT instruction, return address of every call
+  uint32_t static_base;     // R9
+  uint32_t stack_pointer;
+  uint32_t pc_init;
+  uint32_t pc_uninit;
+  uint32_t pc_erase_sector;
+  uint32_t pc_program_page;
+  uint32_t buffer[2];       // page buffers in target RAM
+  uint32_t page_size;
+  uint32_t timeout_ms;      // for one function call
+} flash_algo_t;
+
+typedef struct {
+  const flash_target_t* target;
+  flash_algo_t algo;
+  uint8_t  state;
+  uint8_t  active;          // buffer being filled
+  uint32_t fill;            // bytes in the active buffer
+  uint32_t page_addr;       // flash address of the active buffer
+  uint32_t started;         // millis() when the running function was started
+  uint32_t result;          // R0 of the last function call
+} flash_runner_t;
+
+// Set up the runner with an algorithm already loaded into target RAM.
+//   return: FLASH_RUNNER_OK or FLASH_RUNNER_ERR_PARAM
+uint32_t flash_runner_setup(flash_runner_t* r, const flash_target_t* target, const flash_algo_t* algo);
+
+// Call Init(addr, clk, fnc) and wait for it.
+uint32_t flash_runner_init(flash_runner_t* r, uint32_t addr, uint32_t clk, uint32_t fnc);
+
+// Program what is buffered, then call UnInit(fnc) and wait for it.
+uint32_t flash_runner_uninit(flash_runner_t* r, uint32_t fnc);
+
+// Call EraseSector(addr) and wait for it.
+uint32_t flash_runner_erase(flash_runner_t* r, uint32_t addr);
+
+// Stream page data. ProgramPage is started on every full page, and data
+// that follows is written into the other buffer while it runs.
+// Non-contiguous addr starts a new page.
+uint32_t flash_runner_write(flash_runner_t* r, uint32_t addr, const uint8_t* data, uint32_t len);
+
+// Program a partial page and wait until programming has finished.
+uint32_t flash_runner_flush(flash_runner_t* r);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _FLASH_RUNNER_H_ */
@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#include "itm_filter.h"
+
+// Parser states
+enum {
+  STATE_HEADER = 0,
+  STATE_PAYLOAD,      // fixed number of payload bytes
+  STATE_CONTINUATION, // payload bytes up to one with bit 7 clear
+  STATE_SYNC,         // zero bytes up to 0x80
+  STATE_UNSYNCED,     // waiting for a synchronization packet
+};
+
+// A synchronization packet is at least 47 zero bits followed by a one.
+// No other packet holds this many zero bytes in a row.
+#define SYNC_ZEROS          5U
+// Payload bytes of timestamp and extension packets at most
+#define MAX_CONTINUATION    4U
+
+static void start_packet(itm_filter_t* f, uint8_t type, uint8_t state, uint8_t remain)
+{
+  f->keep   = (f->types & type) ? 1U : 0U;
+  f->state  = state;
+  f->remain = remain;
+}
+
+static void parse_header(itm_filter_t* f, uint8_t b)
+{
+  unsigned size = b & 3U;
+
+  if (size) {
+    // Source packet: 1, 2 or 4 payload bytes
+    if (size == 3U) size = 4U;
+    if (b & 4U) {
+      start_packet(f, ITM_FILTER_HARDWARE, STATE_PAYLOAD, size);
+    } else {
+      start_packet(f, ITM_FILTER_INSTRUMENTATION, STATE_PAYLOAD, size);
+      if (f->ports != 0xFFFFFFFFU) {
+        if (f->page || !(f->ports & (1UL << (b >> 3)))) f->keep = 0U;
+      }
+    }
+  } else if (b == 0x00U) {
+    start_packet(f, ITM_FILTER_SYNC, STATE_SYNC, 0U);
+  } else if (b == 0x70U) {
+    start_packet(f, ITM_FILTER_OVERFLOW, STATE_HEADER, 0U);
+  } else if ((b & 0x0FU) == 0x00U) {
+    // Local timestamp: format 1 is followed by payload, format 2 is not
+    if ((b & 0xC0U) == 0xC0U) {
+      start_packet(f, ITM_FILTER_TIMESTAMP, STATE_CONTINUATION, MAX_CONTINUATION);
+    } else if (!(b & 0x80U)) {
+      start_packet(f, ITM_FILTER_TIMESTAMP, STATE_HEADER, 0U);
+    } else {
+      itm_filter_desync(f);
+    }
+  } else if ((b == 0x94U) || (b == 0xB4U)) {
+    // Global timestamp 1 and 2
+    start_packet(f, ITM_FILTER_TIMESTAMP, STATE_CONTINUATION, MAX_CONTINUATION);
+  } else if ((b & 0x0BU) == 0x08U) {
+    if (b & 0x80U) {
+      start_packet(f, ITM_FILTER_EXTENSION, STATE_CONTINUATION, MAX_CONTINUATION);
+    } else {
+      start_packet(f, ITM_FILTER_EXTENSION, STATE_HEADER, 0U);
+      // Stimulus port page for the following instrumentation packets
+      if (!(b & 4U)) f->page = (b >> 4) & 7U;
+    }
+  } else {
+    // Reserved header
+    itm_filter_desync(f);
+  }
+}
+
+void itm_filter_init(itm_filter_t* f, uint32_t ports, uint32_t types)
+{
+  f->ports   = ports;
+  f->types   = (uint8_t)types;
+  f->state   = STATE_HEADER;
+  f->remain  = 0U;
+  f->keep    = 0U;
+  f->zeros   = 0U;
+  f->page    = 0U;
+  f->dropped = 0U;
+}
+
+bool itm_filter_keeps_all(const itm_filter_t* f)
+{
+  return (f->ports == 0xFFFFFFFFU) && ((f->types & ITM_FILTER_ALL) == ITM_FILTER_ALL);
+}
+
+void itm_filter_desync(itm_filter_t* f)
+{
+  f->state = STATE_UNSYNCED;
+  f->keep  = 0U;
+}
+
+bool itm_filter_byte(itm_filter_t* f, uint8_t b)
+{
+  uint8_t zeros = f->zeros; // zero bytes right before b
+
+  if (b) {
+    f->zeros = 0U;
+  } else if (zeros < SYNC_ZEROS) {
+    f->zeros = zeros + 1U;
+  }
+
+  switch (f->state) {
+    case STATE_HEADER:
+      parse_header(f, b);
+      break;
+    case STATE_PAYLOAD:
+      if (f->zeros >= SYNC_ZEROS) {
+        // Packet alignment was lost, this is a synchronization packet
+        start_packet(f, ITM_FILTER_SYNC, STATE_SYNC, 0U);
+      } else if (!--f->remain) {
+        f->state = STATE_HEADER;
+      }
+      break;
+    case STATE_CONTINUATION:
+      if (!(b & 0x80U) || !--f->remain) {
+        f->state = STATE_HEADER;
+      }
+      break;
+    case STATE_SYNC:
+      if (b == 0x80U) {
+        f->state = STATE_HEADER;
+        f->page  = 0U;
+      } else if (b) {
+        itm_filter_desync(f);
+      }
+      break;
+    default:
+      if ((b == 0x80U) && (zeros >= SYNC_ZEROS)) {
+        f->state = STATE_HEADER;
+        f->page  = 0U;
+      }
+      break;
+  }
+  if (!f->keep) ++f->dropped;
+  return f->keep;
+}
+
+uint32_t itm_filter_run(itm_filter_t* f, uint8_t* buf, uint32_t len)
+{
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < len; ++i) {
+    uint8_t b = buf[i];
+    if (itm_filter_byte(f, b)) buf[kept++] = b;
+  }
+  return kept;
+}
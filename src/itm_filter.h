@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#ifndef _ITM_FILTER_H_
+#define _ITM_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// ITM/DWT packet filter
+//--------------------------------------------------------------------+
+// Parses the ITM/DWT packet protocol carried by SWO and drops the packets
+// the host is not interested in, so that they never take USB bandwidth.
+// A packet is kept or dropped as a whole; the decision is made on its
+// header byte, so the filter works in place on a byte stream.
+
+// Packet types
+#define ITM_FILTER_SYNC             (1U << 0)
+#define ITM_FILTER_OVERFLOW         (1U << 1)
+#define ITM_FILTER_TIMESTAMP        (1U << 2)  // local and global timestamps
+#define ITM_FILTER_EXTENSION        (1U << 3)
+#define ITM_FILTER_INSTRUMENTATION  (1U << 4)  // software source, also selected by stimulus port
+#define ITM_FILTER_HARDWARE         (1U << 5)  // DWT source
+#define ITM_FILTER_ALL              0x3FU
+
+typedef struct {
+  uint32_t ports;     // stimulus ports 0..31 to keep
+  uint8_t  types;     // ITM_FILTER_* to keep
+  uint8_t  state;
+  uint8_t  remain;    // payload bytes left in the current packet
+  uint8_t  keep;      // current packet is kept
+  uint8_t  zeros;     // consecutive zero bytes
+  uint8_t  page;      // stimulus port page set by extension packets
+  uint32_t dropped;   // number of dropped bytes
+} itm_filter_t;
+
+// Initialize the filter. The stream is expected to start at a packet header.
+//   ports: bit n keeps stimulus port n. Ports beyond 31 are kept only if all bits are set.
+//   types: ITM_FILTER_* to keep
+void itm_filter_init(itm_filter_t* f, uint32_t ports, uint32_t types);
+
+// True if every packet is kept, so that the stream need not go through the filter.
+bool itm_filter_keeps_all(const itm_filter_t* f);
+
+// Drop everything until the next synchronization packet,
+// e.g. after trace data has been lost.
+void itm_filter_desync(itm_filter_t* f);
+
+// Feed one byte.
+//   return: true if the byte is kept
+bool itm_filter_byte(itm_filter_t* f, uint8_t b);
+
+// Filter a buffer in place.
+//   return: number of kept bytes, moved to the start of buf
+uint32_t itm_filter_run(itm_filter_t* f, uint8_t* buf, uint32_t len);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _ITM_FILTER_H_ */
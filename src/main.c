@@ -25,6 +25,8 @@
 #include <string.h>
 
 #include "cmsis_dap_device.h"
+#include "dap_executor.h"
+#include "itm_filter.h"
 #include "board.h"
 #include "tusb.h"
 #include "usb_descriptors.h"
@@ -35,11 +37,14 @@
 // MACRO CONSTANT TYPEDEF PROTOTYPE
 //--------------------------------------------------------------------+
 
-//#define DEBUG
 #define URL  "studio.keil.arm.com/auth/login/"
 
 uint32_t SWO_GetTraceMode(void);
-uint8_t GetTraceStatus(void);
+uint32_t SWO_IsCaptureActive(void);
+void SetTraceError(uint8_t flag);
+void SWO_CaptureTimestamp(uint32_t num);
+uint32_t UART_GetTransport(void);
+void UART_Process(void);
 bool tud_vendor_control_xfer_cb(uint8_t rhport, uint8_t stage,  const tusb_control_request_t * request);
 
 const tusb_desc_webusb_url_t desc_url =
@@ -66,6 +71,17 @@ usbd_class_driver_t const cmsis_dap = {
 void cdc_task(void);
 void dap_task(void);
 
+#if (DAP_DUAL_CORE != 0)
+// Core1 executes DAP commands while core0 services USB and the CDC bridge.
+static void core1_main(void)
+{
+  while (1)
+  {
+    dap_execute_requests(DAP_EXECUTE_BUDGET);
+  }
+}
+#endif
+
 /*------------- MAIN -------------*/
 int main(void)
 {
@@ -76,9 +92,16 @@ int main(void)
 
   DAP_Setup();
 
+#if (DAP_DUAL_CORE != 0)
+  board_multicore_launch(core1_main);
+#endif
+
   while (1)
   {
     tud_task(); // tinyusb device task
+#if (DAP_DUAL_CORE != 0)
+    tud_cmsis_dap_task();
+#endif
     cdc_task();
     dap_task();
   }
@@ -171,52 +194,191 @@ void cdc_printf(const char* str, ...)
   tud_cdc_write_str(buf);
 }
 
-void dap_task(void)
+#if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
+#if (SWO_ITM_FILTER != 0)
+static itm_filter_t swo_filter;
+#if (SWO_UART_DMA != 0)
+// DMA lands here so that dropped packets leave no gap in the trace buffer.
+// A filter that keeps everything is skipped and DMA goes straight to the
+// trace buffer.
+#define SWO_STAGING_SIZE  4096U
+static uint8_t swo_staging[SWO_STAGING_SIZE] TU_ATTR_ALIGNED(SWO_STAGING_SIZE);
+static unsigned swo_staging_rd;
+static bool swo_staged;
+#endif
+
+// Pass the packets selected by SWO_ITM_PORTS and SWO_ITM_PACKETS to the trace buffer
+static void swo_filter_enqueue(uint8_t *buf, unsigned len)
 {
-  const uint8_t *p_req;
-  uint8_t *p_rsp;
-  unsigned sz_req = tud_cmsis_dap_acquire_request_buffer(&p_req);
-  if (sz_req) {
-    unsigned sz_rsp = tud_cmsis_dap_acquire_response_buffer(&p_rsp);
-    TU_ASSERT(sz_rsp,);
+  len = itm_filter_run(&swo_filter, buf, len);
+  if (!len) return;
+  len = tud_cmsis_dap_swo_enqueue(buf, len);
+  if (len) SWO_CaptureTimestamp(len);
+}
+#endif
 
-    uint32_t result = DAP_ExecuteCommand(p_req, p_rsp);
-#ifdef DEBUG
-    cdc_printf("%x %x -> %lx %x\n", p_req[0], sz_req, result, p_rsp[1]);
+#if (SWO_UART_DMA != 0)
+// DMA capture runs, set on core0 only
+static bool swo_capturing;
+
+// Trace data was lost before the trace buffer
+static void swo_capture_overrun(void)
+{
+#if (SWO_ITM_FILTER != 0)
+  // The next byte need not be a packet header
+  itm_filter_desync(&swo_filter);
 #endif
+  SetTraceError(DAP_SWO_BUFFER_OVERRUN);
+}
+#endif
+
+// Invoked when the trace buffer is full
+void tud_cmsis_dap_swo_overrun_cb(uint8_t itf)
+{
+  (void)itf;
+  SetTraceError(DAP_SWO_BUFFER_OVERRUN);
+}
 
-    tud_cmsis_dap_release_request_buffer();
-    tud_cmsis_dap_release_response_buffer(result & 0xFFFFU);
+#if (DAP_DUAL_CORE != 0)
+// SWO commands run on core1, while core0 commits captured data to the trace
+// buffer and sends it over USB. Calls that reprogram the capture or move
+// the read index of the trace buffer are handed over to dap_task on core0.
+static struct {
+  uint32_t (*volatile func)(uint32_t arg);
+  uint32_t arg;
+  uint32_t result;
+} swo_call;
+
+static uint32_t swo_call_core0(uint32_t (*func)(uint32_t arg), uint32_t arg)
+{
+  swo_call.arg = arg;
+  __DMB();
+  swo_call.func = func;
+  while (swo_call.func) {
+  }
+  __DMB();
+  return swo_call.result;
+}
 
+static void swo_call_service(void)
+{
+  uint32_t (*func)(uint32_t arg) = swo_call.func;
+  if (!func) return;
+  __DMB();
+  swo_call.result = func(swo_call.arg);
+  __DMB();
+  swo_call.func = NULL;
+}
+#else
+#define swo_call_core0(func, arg)   (func)(arg)
+#endif
+#endif
+
+void dap_task(void)
+{
+#if (DAP_DUAL_CORE == 0)
+  dap_execute_requests(DAP_EXECUTE_BUDGET);
+#endif
 #ifdef DEBUG
-    tud_cdc_write_flush();
+  tud_cdc_write_flush();
+#endif
+#if (((SWO_UART != 0) || (SWO_MANCHESTER != 0)) && (DAP_DUAL_CORE != 0))
+  swo_call_service();
 #endif
-  }
 
-#if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
-  if (GetTraceStatus() & DAP_SWO_CAPTURE_ACTIVE) {
+#if (SWO_UART_DMA != 0)
+  if (swo_capturing) {
+    bool overrun = false;
+    unsigned len = board_swo_captured(&overrun);
+#if (SWO_ITM_FILTER != 0)
+    if (swo_staged) {
+      if (len > sizeof(swo_staging)) {
+        swo_staging_rd = (swo_staging_rd + len) % sizeof(swo_staging);
+        overrun = true;
+        len = 0;
+      }
+      while (len) {
+        unsigned n = TU_MIN(len, sizeof(swo_staging) - swo_staging_rd);
+        swo_filter_enqueue(&swo_staging[swo_staging_rd], n);
+        swo_staging_rd = (swo_staging_rd + n) % sizeof(swo_staging);
+        len -= n;
+      }
+    }
+#endif
+    // Otherwise DMA has already stored the data in the trace buffer
+    if (len && tud_cmsis_dap_swo_commit(len)) {
+      SWO_CaptureTimestamp(len);
+    }
+    if (overrun) swo_capture_overrun();
+  }
+#elif ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
+  if (SWO_IsCaptureActive()) {
     unsigned reminder = tud_cmsis_dap_swo_free();
     if (reminder) {
       unsigned len = 0;
       uint8_t buf[64];
-      if (DAP_SWO_UART == SWO_GetTraceMode()) {
+      uint32_t mode = SWO_GetTraceMode();
+      if ((DAP_SWO_UART == mode) || (DAP_SWO_MANCHESTER == mode)) {
         len = board_swo_read(buf, sizeof(buf));
       }
-      if (len) tud_cmsis_dap_swo_enqueue(buf, len);
+#if (SWO_ITM_FILTER != 0)
+      swo_filter_enqueue(buf, len);
+#else
+      len = tud_cmsis_dap_swo_enqueue(buf, len);
+      if (len) SWO_CaptureTimestamp(len);
+#endif
     }
   }
 #endif
+#if (SWO_STREAM != 0)
+  tud_cmsis_dap_swo_task(board_millis());
+#endif
+#if (DAP_UART != 0)
+  UART_Process();
+#endif
 }
 
+#if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
+// Both SWO modes share the state machine and the capture path
+static uint32_t swo_control(uint32_t active)
+{
+#if (SWO_ITM_FILTER != 0)
+  if (active) {
+    itm_filter_init(&swo_filter, SWO_ITM_PORTS, SWO_ITM_PACKETS);
+  }
+#endif
+#if (SWO_UART_DMA != 0)
+  if (active) {
+#if (SWO_ITM_FILTER != 0)
+    swo_staged = !itm_filter_keeps_all(&swo_filter);
+    if (swo_staged) {
+      swo_staging_rd = 0;
+      swo_capturing = board_swo_start_capture(swo_staging, sizeof(swo_staging)) != 0;
+      return swo_capturing;
+    }
+#endif
+    uint8_t *buf;
+    uint32_t size = tud_cmsis_dap_swo_buffer(&buf);
+    swo_capturing = board_swo_start_capture(buf, size) != 0;
+    return swo_capturing;
+  }
+  swo_capturing = false;
+  board_swo_stop_capture();
+#else
+  (void)active;
+#endif
+  return 1;
+}
+#endif
+
 #if (SWO_UART != 0)
-uint32_t SWO_Mode_UART(uint32_t enable)
+static uint32_t swo_mode_uart(uint32_t enable)
 {
   int ret = board_swo_set_enabled(enable);
   return ret;
 }
 
-//   return:   actual baudrate or 0 when not configured
-uint32_t SWO_Baudrate_UART(uint32_t baudrate)
+static uint32_t swo_baudrate_uart(uint32_t baudrate)
 {
   if (baudrate > SWO_UART_MAX_BAUDRATE) {
     baudrate = SWO_UART_MAX_BAUDRATE;
@@ -224,65 +386,213 @@ uint32_t SWO_Baudrate_UART(uint32_t baudrate)
   return board_swo_set_baudrate(baudrate);
 }
 
+uint32_t SWO_Mode_UART(uint32_t enable)
+{
+  return swo_call_core0(swo_mode_uart, enable);
+}
+
+//   return:   actual baudrate or 0 when not configured
+uint32_t SWO_Baudrate_UART(uint32_t baudrate)
+{
+  return swo_call_core0(swo_baudrate_uart, baudrate);
+}
+
 uint32_t SWO_Control_UART(uint32_t active)
 {
-  return 1;
+  return swo_call_core0(swo_control, active);
 }
 #endif
 
-#if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
-uint32_t TraceBuffer_IsUpdated(void)
+#if (SWO_MANCHESTER != 0)
+static uint32_t swo_mode_manchester(uint32_t enable)
 {
-  return 0;
+  int ret = board_swo_manchester_set_enabled(enable);
+  return ret;
+}
+
+static uint32_t swo_baudrate_manchester(uint32_t baudrate)
+{
+  if (baudrate > SWO_MANCHESTER_MAX_BAUDRATE) {
+    baudrate = SWO_MANCHESTER_MAX_BAUDRATE;
+  }
+  return board_swo_manchester_set_baudrate(baudrate);
+}
+
+uint32_t SWO_Mode_Manchester(uint32_t enable)
+{
+  return swo_call_core0(swo_mode_manchester, enable);
+}
+
+//   return:   actual baudrate or 0 when not configured
+uint32_t SWO_Baudrate_Manchester(uint32_t baudrate)
+{
+  return swo_call_core0(swo_baudrate_manchester, baudrate);
+}
+
+uint32_t SWO_Control_Manchester(uint32_t active)
+{
+  return swo_call_core0(swo_control, active);
 }
 
+uint32_t SWO_GetCount_Manchester(void)
+{
+  return tud_cmsis_dap_swo_used();
+}
+#endif
+
+#if ((SWO_UART != 0) || (SWO_MANCHESTER != 0))
 uint32_t TraceBuffer_GetCount(void)
 {
   return tud_cmsis_dap_swo_used();
 }
 
+static uint32_t swo_clear(uint32_t arg)
+{
+  (void)arg;
+  return tud_cmsis_dap_swo_clear();
+}
+
 void TraceBuffer_Clear(void)
 {
-  tud_cmsis_dap_swo_clear();
+  swo_call_core0(swo_clear, 0);
+}
+
+static uint8_t *swo_drain_data;
+
+static uint32_t swo_drain(uint32_t num)
+{
+  return tud_cmsis_dap_swo_dequeue(swo_drain_data, num);
 }
 
 void TraceBuffer_Drain(uint8_t *data, uint32_t num)
 {
-   tud_cmsis_dap_swo_dequeue(data, num);
+  swo_drain_data = data;
+  swo_call_core0(swo_drain, num);
+}
+#endif
+
+#if (DAP_UART != 0)
+//   return:   actual baudrate or 0 when not configured
+uint32_t UART_Baudrate(uint32_t baudrate)
+{
+  return board_uart_set_baudrate(baudrate);
+}
+
+//   return:   1 - Success, 0 - Error
+uint32_t UART_Format(uint32_t data_bits, uint32_t parity, uint32_t stop_bits)
+{
+  return board_uart_set_format(data_bits, parity, stop_bits);
+}
+
+uint32_t UART_Read(uint8_t *buf, uint32_t num)
+{
+  return board_uart_read(buf, num);
+}
+
+uint32_t UART_RxOverrun(void)
+{
+  return board_uart_rx_overrun();
+}
+
+uint32_t UART_Write(const uint8_t *buf, uint32_t num)
+{
+  return board_uart_write(buf, num);
 }
 #endif
 
 //--------------------------------------------------------------------+
 // USB CDC
 //--------------------------------------------------------------------+
+#ifndef DEBUG
+static struct {
+  uint32_t pending;   // bytes queued since the last flush
+  uint32_t first;     // board_millis() when the oldest pending byte arrived
+  uint32_t last;      // board_millis() when the latest pending byte arrived
+  uint32_t idle_ms;   // CDC_FLUSH_IDLE_CHARS at the current bit rate
+} cdc_flush = {
+  .idle_ms = 1,
+};
+
+// Flush when a packet fills, the line goes idle or the latency bound expires.
+static void cdc_flush_update(uint32_t len)
+{
+  uint32_t now = board_millis();
+  if (len) {
+    if (!cdc_flush.pending) cdc_flush.first = now;
+    cdc_flush.pending += len;
+    cdc_flush.last = now;
+  }
+  if (!cdc_flush.pending) return;
+  if ((cdc_flush.pending >= CFG_TUD_CDC_EP_BUFSIZE) ||
+      ((now - cdc_flush.last) >= cdc_flush.idle_ms) ||
+      ((now - cdc_flush.first) >= CDC_FLUSH_LATENCY_MS)) {
+    tud_cdc_write_flush();
+    cdc_flush.pending = 0;
+  }
+}
+#endif
+
+static void cdc_apply_line_coding(cdc_line_coding_t const* line_coding)
+{
+  board_uart_set_format(line_coding->data_bits, line_coding->parity, line_coding->stop_bits);
+  board_uart_set_baudrate(line_coding->bit_rate);
+#ifndef DEBUG
+  // 10 bits per character, rounded up to whole milliseconds
+  uint32_t rate = line_coding->bit_rate ? line_coding->bit_rate : 1U;
+  uint32_t ms = (CDC_FLUSH_IDLE_CHARS * 10U * 1000U + rate - 1U) / rate;
+  cdc_flush.idle_ms = ms ? ms : 1U;
+#endif
+}
+
 void cdc_task(void)
 {
 #ifndef DEBUG
   static uint8_t tx_buf[64];
   static unsigned tx_length;
   static unsigned tx_index;
-  static uint8_t rx_buf[64];
-  static unsigned rx_length;
-  static unsigned rx_index;
-
+  uint8_t rx_buf[64];
+
+#if (DAP_UART != 0)
+  static bool uart_released;
+  if (UART_GetTransport() != DAP_UART_TRANSPORT_USB_COM_PORT) {
+    // DAP_UART commands own the UART; leave its data to UART_Process and
+    // drop what the host sends
+    if (tud_cdc_connected()) tud_cdc_read_flush();
+    tx_index = 0;
+    tx_length = 0;
+    cdc_flush.pending = 0;
+    uart_released = true;
+    return;
+  }
+  if (uart_released) {
+    // The line coding was not applied while DAP_UART commands owned the UART
+    cdc_line_coding_t line_coding;
+    tud_cdc_get_line_coding(&line_coding);
+    cdc_apply_line_coding(&line_coding);
+    uart_released = false;
+  }
+#endif
   if ( ! tud_cdc_connected() ) {
     // clear FIFO
     board_uart_read(rx_buf, sizeof(rx_buf));
     tx_index = 0;
     tx_length = 0;
-    rx_index = 0;
-    rx_length = 0;
+    cdc_flush.pending = 0;
     return;
   }
 
-  if (rx_index == rx_length) {
-    rx_index = 0;
-    rx_length = board_uart_read(rx_buf, sizeof(rx_buf));
+  // Take only what the CDC FIFO accepts; the rest stays in the UART buffer
+  // until it overruns.
+  unsigned rx_length = TU_MIN(tud_cdc_write_available(), sizeof(rx_buf));
+  if (rx_length) {
+    rx_length = board_uart_read(rx_buf, rx_length);
   }
-  if (rx_index < rx_length) {
-    rx_index += tud_cdc_write(&rx_buf[rx_index], rx_length - rx_index);
-    tud_cdc_write_flush();
+  // CDC has no way to report the loss
+  (void)board_uart_rx_overrun();
+  if (rx_length) {
+    rx_length = tud_cdc_write(rx_buf, rx_length);
   }
+  cdc_flush_update(rx_length);
 
   if ((tx_index == tx_length) && tud_cdc_available()) {
     tx_index = 0;
@@ -301,7 +611,10 @@ void cdc_task(void)
 void tud_cdc_line_coding_cb(uint8_t itf, cdc_line_coding_t const* line_coding)
 {
   (void)itf;
-  board_uart_set_baudrate(line_coding->bit_rate);
+#if (DAP_UART != 0)
+  if (UART_GetTransport() != DAP_UART_TRANSPORT_USB_COM_PORT) return;
+#endif
+  cdc_apply_line_coding(line_coding);
 }
 
 usbd_class_driver_t const* usbd_app_driver_get_cb(uint8_t* driver_count)
@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#include <stddef.h>
+
+#include "rle.h"
+
+static uint32_t get32(const uint8_t* p)
+{
+  return ((uint32_t)p[0] <<  0) |
+         ((uint32_t)p[1] <<  8) |
+         ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static void put32(uint8_t* p, uint32_t v)
+{
+  p[0] = (uint8_t)(v >>  0);
+  p[1] = (uint8_t)(v >>  8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+uint32_t rle_parse(const uint8_t* src, uint32_t len, rle_token_t* token)
+{
+  if (len == 0U) return 0U;
+
+  if (src[0] & 0x80U) {
+    if (len < RLE_RUN_SIZE) return 0U;
+    token->count = ((((uint32_t)src[0] & 0x7FU) << 8) | src[1]) + 1U;
+    token->value = get32(&src[2]);
+    token->data  = NULL;
+    return RLE_RUN_SIZE;
+  }
+
+  uint32_t count = ((uint32_t)src[0] & 0x7FU) + 1U;
+  if (len < (1U + (count * 4U))) return 0U;
+  token->count = count;
+  token->value = 0U;
+  token->data  = &src[1];
+  return 1U + (count * 4U);
+}
+
+//--------------------------------------------------------------------+
+// Encoder
+//--------------------------------------------------------------------+
+// The last word(s) are held back as a pending run, since the next word may
+// extend it. Space for writing the pending run is kept free in dst all the
+// time, so that rle_encoder_finish() cannot fail.
+
+// Bytes needed to write a pending run of count words
+static uint32_t pending_size(const rle_encoder_t* e, uint32_t count)
+{
+  if (count == 0U) return 0U;
+  if (count >= 2U) return RLE_RUN_SIZE;
+  // A single word joins the open literal
+  return (e->lit_count && (e->lit_count < RLE_LITERAL_MAX)) ? 4U : 5U;
+}
+
+static void write_pending(rle_encoder_t* e)
+{
+  if (e->run_count >= 2U) {
+    uint32_t n = e->run_count - 1U;
+    e->dst[e->len++] = (uint8_t)(0x80U | (n >> 8));
+    e->dst[e->len++] = (uint8_t)n;
+    put32(&e->dst[e->len], e->run_value);
+    e->len += 4U;
+    e->lit_count = 0U;
+  } else if (e->run_count == 1U) {
+    if (!e->lit_count || (e->lit_count >= RLE_LITERAL_MAX)) {
+      e->lit = e->len++;
+      e->lit_count = 0U;
+    }
+    e->dst[e->lit] = (uint8_t)e->lit_count++;
+    put32(&e->dst[e->len], e->run_value);
+    e->len += 4U;
+  }
+  e->run_count = 0U;
+}
+
+void rle_encoder_init(rle_encoder_t* e, uint8_t* dst, uint32_t size)
+{
+  e->dst       = dst;
+  e->size      = size;
+  e->len       = 0U;
+  e->lit       = 0U;
+  e->lit_count = 0U;
+  e->run_value = 0U;
+  e->run_count = 0U;
+  e->words     = 0U;
+}
+
+bool rle_encode(rle_encoder_t* e, uint32_t word)
+{
+  if (e->run_count && (word == e->run_value) && (e->run_count < RLE_RUN_MAX)) {
+    if ((e->len + pending_size(e, e->run_count + 1U)) > e->size) return false;
+    e->run_count++;
+  } else {
+    // The pending run always fits, the new word may not
+    write_pending(e);
+    if ((e->len + pending_size(e, 1U)) > e->size) return false;
+    e->run_value = word;
+    e->run_count = 1U;
+  }
+  e->words++;
+  return true;
+}
+
+uint32_t rle_encoder_finish(rle_encoder_t* e)
+{
+  write_pending(e);
+  return e->len;
+}
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#ifndef _RLE_H_
+#define _RLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// Run-length coding of target memory
+//--------------------------------------------------------------------+
+// Memory is coded as a sequence of 32-bit words, little endian.
+// A stream is a sequence of tokens:
+//   literal: 0b0nnnnnnn, then n + 1 words (1..128)
+//   run:     0b1nnnnnnn nnnnnnnn, then one word repeated n + 1 times (1..32768)
+
+#define RLE_LITERAL_MAX     128U
+#define RLE_RUN_MAX         32768U
+#define RLE_RUN_SIZE        6U      // bytes of a run token
+
+typedef struct {
+  uint32_t count;         // number of words
+  uint32_t value;         // repeated word of a run
+  const uint8_t* data;    // words of a literal, NULL for a run
+} rle_token_t;
+
+// Parse the token at the start of src.
+//   return: bytes taken by the token, 0 if src does not start with a complete token
+uint32_t rle_parse(const uint8_t* src, uint32_t len, rle_token_t* token);
+
+typedef struct {
+  uint8_t* dst;
+  uint32_t size;          // capacity of dst
+  uint32_t len;           // bytes written to dst
+  uint32_t lit;           // offset of the header of the open literal
+  uint32_t lit_count;     // words in the open literal, 0 if none is open
+  uint32_t run_value;     // pending word, not written yet
+  uint32_t run_count;
+  uint32_t words;         // number of words taken
+} rle_encoder_t;
+
+// Start a stream in dst.
+void rle_encoder_init(rle_encoder_t* e, uint8_t* dst, uint32_t size);
+
+// Add one word. Words that are taken always fit into dst.
+//   return: false if dst is full and the word was not taken
+bool rle_encode(rle_encoder_t* e, uint32_t word);
+
+// Write the pending word(s).
+//   return: length of the stream
+uint32_t rle_encoder_finish(rle_encoder_t* e);
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _RLE_H_ */
@@ -42,6 +42,7 @@ This information includes:
 #include <RP2040.h>
 #include <hardware/structs/resets.h>
 #include <hardware/gpio.h>
+#include <hardware/structs/timer.h>
 
 /// Processor Clock of the Cortex-M MCU used in the Debug Unit.
 /// This value is used to calculate the SWD/JTAG clock speed.
@@ -61,7 +62,7 @@ This information includes:
 
 /// Indicate that JTAG communication mode is available at the Debug Port.
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
-#define DAP_JTAG                0               ///< JTAG Mode: 1 = available, 0 = not available.
+#define DAP_JTAG                1               ///< JTAG Mode: 1 = available, 0 = not available.
 
 /// Configure maximum number of JTAG devices on the scan chain connected to the Debug Access Port.
 /// This setting impacts the RAM requirements of the Debug Unit. Valid range is 1 .. 255.
@@ -76,6 +77,10 @@ This information includes:
 /// The command \ref DAP_SWJ_Clock can be used to overwrite this default setting.
 #define DAP_DEFAULT_SWJ_CLOCK   1000000U        ///< Default SWD/JTAG clock frequency in Hz.
 
+/// Maximum SWD/JTAG clock generated by the PIO engines.
+/// Requests of \ref DAP_SWJ_Clock above this rate run at this rate.
+#define SWJ_PIO_MAX_CLOCK       25000000U       ///< Maximum SWD/JTAG clock frequency in Hz.
+
 /// Maximum Package Size for Command and Response data.
 /// This configuration settings is used to optimize the communication performance with the
 /// debugger and depends on the USB peripheral. Typical vales are 64 for Full-speed USB HID or WinUSB,
@@ -88,6 +93,19 @@ This information includes:
 /// setting can be reduced (valid range is 1 .. 255).
 #define DAP_PACKET_COUNT        64U              ///< Specifies number of packets buffered.
 
+/// Size of the request and the response packet arena, each.
+/// Packets are stored by their actual size, so small requests and responses take less than
+/// \ref DAP_PACKET_SIZE. It must hold at least one packet of \ref DAP_PACKET_SIZE.
+#define DAP_PACKET_ARENA_SIZE   4096U           ///< Packet arena size in bytes per direction.
+
+/// Maximum number of requests executed per main loop pass.
+/// Received requests are executed back to back up to this count before USB is serviced again.
+#define DAP_EXECUTE_BUDGET      16U             ///< Requests per main loop pass (1 .. DAP_PACKET_COUNT).
+
+/// Execute DAP commands on the second core.
+/// USB and the CDC bridge keep being serviced on core0 while a long command runs.
+#define DAP_DUAL_CORE           1               ///< Dual core: 1 = core1 executes commands, 0 = single superloop.
+
 /// Indicate that UART Serial Wire Output (SWO) trace is available.
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
 #define SWO_UART                1               ///< SWO UART:  1 = available, 0 = not available.
@@ -96,26 +114,57 @@ This information includes:
 #define SWO_UART_DRIVER         0               ///< USART Driver instance number (Driver_USART#).
 
 /// Maximum SWO UART Baudrate.
-#define SWO_UART_MAX_BAUDRATE   10000000U       ///< SWO UART Maximum Baudrate in Hz.
+/// SWO UART is received by a PIO state machine taking 8 cycles per bit.
+#define SWO_UART_MAX_BAUDRATE   (CPU_CLOCK / 8U) ///< SWO UART Maximum Baudrate in Hz.
+
+/// Capture UART and Manchester SWO by DMA straight into the trace buffer.
+/// Capture keeps running while DAP commands execute. The trace buffer is aligned to \ref SWO_BUFFER_SIZE.
+#define SWO_UART_DMA            1               ///< SWO UART DMA: 1 = DMA ring, 0 = polled by the main loop.
 
 /// Indicate that Manchester Serial Wire Output (SWO) trace is available.
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
-#define SWO_MANCHESTER          0               ///< SWO Manchester:  1 = available, 0 = not available.
+#define SWO_MANCHESTER          1               ///< SWO Manchester:  1 = available, 0 = not available.
+
+/// Maximum SWO Manchester Baudrate.
+/// SWO Manchester is decoded by a PIO state machine taking 16 cycles per bit.
+#define SWO_MANCHESTER_MAX_BAUDRATE (CPU_CLOCK / 16U) ///< SWO Manchester Maximum Baudrate in Hz.
 
 /// SWO Trace Buffer Size.
-#define SWO_BUFFER_SIZE         4096U           ///< SWO Trace Buffer Size in bytes (must be 2^n).
+#define SWO_BUFFER_SIZE         32768U          ///< SWO Trace Buffer Size in bytes (must be 2^n).
+
+/// SWO Trace Buffer policy when full.
+/// Dropping the newest data is reported as a trace buffer overrun.
+#define SWO_BUFFER_OVERWRITE    0               ///< 1 = drop the oldest data, 0 = drop the newest data.
 
 /// SWO Streaming Trace.
 #define SWO_STREAM              1               ///< SWO Streaming Trace: 1 = available, 0 = not available.
 
+/// SWO Streaming Trace aggregation.
+/// A stream transfer starts once a block is buffered, or when data has been pending for the timeout.
+#define SWO_STREAM_BLOCK_SIZE   512U            ///< Maximum stream transfer in bytes.
+#define SWO_STREAM_TIMEOUT      50U             ///< Flush timeout in ms.
+
+/// Filter ITM/DWT packets of the SWO trace on the probe.
+/// Packets not selected by \ref SWO_ITM_PORTS and \ref SWO_ITM_PACKETS are dropped before the trace buffer.
+/// With the defaults below every packet is kept and capture bypasses the filter.
+#define SWO_ITM_FILTER          1               ///< SWO ITM filter: 1 = available, 0 = not available.
+
+/// ITM stimulus ports kept by the SWO ITM filter.
+#define SWO_ITM_PORTS           0xFFFFFFFFU     ///< Bit n keeps stimulus port n.
+
+/// ITM/DWT packet types kept by the SWO ITM filter (ITM_FILTER_* in itm_filter.h).
+#define SWO_ITM_PACKETS         0x3FU           ///< 0x3F keeps all packet types.
+
 /// Clock frequency of the Test Domain Timer. Timer value is returned with \ref TIMESTAMP_GET.
-#define TIMESTAMP_CLOCK         100000000U      ///< Timestamp clock in Hz (0 = timestamps not supported).
+#define TIMESTAMP_CLOCK         1000000U        ///< Timestamp clock in Hz (0 = timestamps not supported).
 
 /// Indicate that UART Communication Port is available.
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
-#define DAP_UART                0               ///< DAP UART:  1 = available, 0 = not available.
+#define DAP_UART                1               ///< DAP UART:  1 = available, 0 = not available.
 
 /// USART Driver instance number for the UART Communication Port.
+/// Not used: DAP UART commands and the USB COM Port share the board UART,
+/// switched by DAP_UART_Transport.
 #define DAP_UART_DRIVER         1               ///< USART Driver instance number (Driver_USART#).
 
 /// UART Receive Buffer Size.
@@ -128,6 +177,12 @@ This information includes:
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
 #define DAP_UART_USB_COM_PORT   1               ///< USB COM Port:  1 = available, 0 = not available.
 
+/// Run flash algorithms on the probe with the vendor commands in DAP_vendor.c.
+#define DAP_FLASH_RUNNER        1               ///< Flash runner: 1 = available, 0 = not available.
+
+/// Verify, download and read target memory on the probe with the vendor commands in DAP_vendor.c.
+#define DAP_MEM_COMMANDS        1               ///< Memory commands: 1 = available, 0 = not available.
+
 /// Debug Unit is connected to fixed Target Device.
 /// The Debug Unit may be part of an evaluation board and always connected to a fixed
 /// known device. In this case a Device Vendor, Device Name, Board Vendor and Board Name strings
@@ -309,21 +364,25 @@ of the same I/O port. The following SWDIO I/O Pin functions are provided:
 
 // Configure DAP I/O pins ------------------------------
 
+// SWD and JTAG are clocked by PIO state machines (swd_pio.c, jtag_pio.c)
+void swd_pio_setup(void);
+void swd_pio_off(void);
+void jtag_pio_setup(void);
+void jtag_pio_off(void);
+void swj_pio_wait_idle(void);
+
 /** Setup JTAG I/O pins: TCK, TMS, TDI, TDO, nTRST, and nRESET.
 Configures the DAP Hardware I/O pins for JTAG mode:
  - TCK, TMS, TDI, nTRST, nRESET to output mode and set to high level.
  - TDO to input mode.
 */
 __STATIC_INLINE void PORT_JTAG_SETUP (void) {
-  gpio_set_function(PIN_SWCLK_TCK_BIT, GPIO_FUNC_SIO);
-  gpio_set_function(PIN_SWDIO_TMS_BIT, GPIO_FUNC_SIO);
-  gpio_set_function(PIN_TDI_BIT, GPIO_FUNC_SIO);
-  gpio_set_function(PIN_TDO_BIT, GPIO_FUNC_SIO);
   gpio_set_function(PIN_nRESET_BIT, GPIO_FUNC_SIO);
 
-  gpio_set_mask((1u << PIN_SWCLK_TCK_BIT) | (1u << PIN_SWDIO_TMS_BIT));
-  gpio_set_dir_out_masked((1u << PIN_SWCLK_TCK_BIT) | (1u << PIN_SWDIO_TMS_BIT) | (1u << PIN_TDI_BIT));
-  gpio_set_dir_in_masked(1u << PIN_TDO_BIT);
+  gpio_pull_up(PIN_TDO_BIT);
+
+  swd_pio_off();
+  jtag_pio_setup();
 }
 
 /** Setup SWD I/O pins: SWCLK, SWDIO, and nRESET.
@@ -332,18 +391,16 @@ Configures the DAP Hardware I/O pins for Serial Wire Debug (SWD) mode:
  - TDI, nTRST to HighZ mode (pins are unused in SWD mode).
 */
 __STATIC_INLINE void PORT_SWD_SETUP (void) {
-
-  gpio_set_mask(1u << PIN_SWDIO_TMS_BIT);
-  gpio_set_dir_out_masked((1u << PIN_SWCLK_TCK_BIT) | (1u << PIN_SWDIO_TMS_BIT));
-
-  gpio_set_function(PIN_SWCLK_TCK_BIT, GPIO_FUNC_SIO);
-  gpio_set_function(PIN_SWDIO_TMS_BIT, GPIO_FUNC_SIO);
   gpio_set_function(PIN_nRESET_BIT, GPIO_FUNC_SIO);
 
   gpio_pull_down(PIN_SWCLK_TCK_BIT);
   gpio_pull_up(PIN_SWDIO_TMS_BIT);
   gpio_set_drive_strength(PIN_SWCLK_TCK_BIT, GPIO_DRIVE_STRENGTH_2MA);
   gpio_set_drive_strength(PIN_SWDIO_TMS_BIT, GPIO_DRIVE_STRENGTH_2MA);
+
+  jtag_pio_off();
+  gpio_set_function(PIN_TDI_BIT, GPIO_FUNC_NULL);
+  swd_pio_setup();
 }
 
 /** Disable JTAG/SWD I/O Pins.
@@ -351,6 +408,8 @@ Disables the DAP Hardware I/O pins which configures:
  - TCK/SWCLK, TMS/SWDIO, TDI, TDO, nTRST, nRESET to High-Z mode.
 */
 __STATIC_INLINE void PORT_OFF (void) {
+  swd_pio_off();
+  jtag_pio_off();
   gpio_set_pulls(PIN_SWCLK_TCK_BIT, false, false);
   gpio_set_pulls(PIN_SWDIO_TMS_BIT, false, false);
   gpio_set_function(PIN_SWCLK_TCK_BIT, GPIO_FUNC_NULL);
@@ -514,6 +573,7 @@ __STATIC_FORCEINLINE uint32_t PIN_nRESET_IN  (void) {
            - 1: release device hardware reset.
 */
 __STATIC_FORCEINLINE void     PIN_nRESET_OUT (uint32_t bit) {
+  swj_pio_wait_idle();  // posted SWD/JTAG transfers go out first
   bool out = (bit & 1u) ? false: true;
   gpio_clr_mask(1u << PIN_nRESET_BIT);
   gpio_set_dir(PIN_nRESET_BIT, out);
@@ -561,8 +621,9 @@ __STATIC_INLINE void LED_RUNNING_OUT (uint32_t bit) {
 @{
 Access function for Test Domain Timer.
 
-The value of the Test Domain Timer in the Debug Unit is returned by the function \ref TIMESTAMP_GET. By
-default, the DWT timer is used.  The frequency of this timer is configured with \ref TIMESTAMP_CLOCK.
+The value of the Test Domain Timer in the Debug Unit is returned by the function \ref TIMESTAMP_GET.
+Cortex-M0+ has no DWT cycle counter, so the lower half of the 1 MHz system timer is used
+instead. The frequency of this timer is configured with \ref TIMESTAMP_CLOCK.
 
 */
 
@@ -570,7 +631,7 @@ default, the DWT timer is used.  The frequency of this timer is configured with
 \return Current timestamp value.
 */
 __STATIC_INLINE uint32_t TIMESTAMP_GET (void) {
-  return 0;
+  return timer_hw->timerawl;
 }
 
 ///@}
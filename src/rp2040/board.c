@@ -20,24 +20,321 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE. */
 
+#include <string.h>
+
 #include "RP2040.h"
 #include "hardware/gpio.h"
 #include "hardware/uart.h"
+#include "hardware/timer.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "pico/multicore.h"
 
 #include "board.h"
+#include "crc32.h"
+#include "swo_pio.h"
+#include "uart_pio.h"
 
 #define UART          uart1
 #define UART_TX_PIN   4
 #define UART_RX_PIN   5
-#define SWO           uart0
+#define SWO_PIO       pio1
+#define SWO_SM        0
 #define SWO_RX_PIN    1
 
+// UART bridge rings, 2^n bytes. The receive ring holds about 5 ms at the
+// fastest PIO rate of clk_sys / 8.
+#define UART_RX_SIZE  8192U
+#define UART_TX_SIZE  1024U
+#define UART_TX_IRQ   DMA_IRQ_1
+
+// RTS/CTS hardware flow control on the UART bridge: 1 = enabled
+#define UART_FLOW_CONTROL   0
+#define UART_CTS_PIN        10
+#define UART_RTS_PIN        11
+
+// 8N1 rates that the UART divider misses by more than UART_PIO_TOLERANCE
+// percent, or cannot reach, are bridged by PIO state machines on the same
+// pins. Flow control is not available on this path.
+#define UART_PIO            1
+#define UART_PIO_TOLERANCE  1
+#define UART_RX_SM          1   // on SWO_PIO
+#define UART_TX_SM          2
+
+// Transfers per trigger of a receive ring data channel.
+// The control channel triggers it again with this count when it runs out.
+#define RX_DMA_RELOAD   0x10000000U
+
+static struct {
+  int      rx_data_ch;  // UART RX to uart_rx_buf
+  int      rx_ctrl_ch;  // restarts rx_data_ch
+  uint32_t rx_rd;       // offset of the next byte to read in uart_rx_buf
+  uint32_t rx_used;     // received bytes not read yet
+  uint32_t rx_last;     // transfer count of rx_data_ch at the last read
+  bool     rx_overrun;  // received data was overwritten before it was read
+  int      tx_ch;       // tx_buf to UART TX
+  uint32_t tx_wr;       // free running indices of tx_buf
+  volatile uint32_t tx_rd;
+  volatile uint32_t tx_busy; // bytes being sent by tx_ch
+  uint32_t baudrate;    // requested by the host
+  bool     format_8n1;
+  bool     pio;         // bridged by UART_RX_SM and UART_TX_SM
+  uint32_t pio_clkdiv;  // PIO clock divider in 1/256 steps
+  int      tx_offset;   // uart_tx program
+  uint8_t  tx_buf[UART_TX_SIZE];
+} g_uart = {
+  .baudrate   = 115200,
+  .format_8n1 = true,
+  .tx_offset  = -1,
+};
+
+// DMA write ring must be aligned to its size
+static TU_ATTR_ALIGNED(UART_RX_SIZE) uint8_t uart_rx_buf[UART_RX_SIZE];
+
 static struct {
-  uint32_t baudrate;
+  int      offset;
+  int      manchester_offset;
+  uint32_t clkdiv;    // PIO clock divider in 1/256 steps
+  uint32_t manchester_clkdiv;
+  int      data_ch;   // PIO RX FIFO to trace buffer
+  int      ctrl_ch;   // restarts data_ch
+  uint32_t last;      // transfer count of data_ch at the last poll
 } g_swo = {
-  .baudrate = 115200,
+  .offset   = -1,
+  .manchester_offset = -1,
+  .data_ch  = -1,
+  .ctrl_ch  = -1,
 };
 
+static const pio_program_t swo_program = {
+  .instructions = swo_program_instructions,
+  .length       = SWO_PIO_PROGRAM_LENGTH,
+  .origin       = -1,
+};
+
+static const pio_program_t swo_manchester_program = {
+  .instructions = swo_manchester_program_instructions,
+  .length       = SWO_MANCHESTER_PIO_PROGRAM_LENGTH,
+  .origin       = -1,
+};
+
+static const pio_program_t uart_tx_program = {
+  .instructions = uart_tx_program_instructions,
+  .length       = UART_PIO_TX_PROGRAM_LENGTH,
+  .origin       = -1,
+};
+
+static const uint32_t rx_dma_reload = RX_DMA_RELOAD;
+
+//--------------------------------------------------------------------+
+// DMA receive ring
+//--------------------------------------------------------------------+
+// Receive bytes from src into buf without CPU involvement. The data channel
+// wraps its write address within buf and the control channel restarts it,
+// so the ring runs until rx_ring_stop.
+//   buf: must be aligned to size, which must be 2^n
+static void rx_ring_start(int data_ch, int ctrl_ch, const volatile void* src, uint dreq, uint8_t* buf, unsigned size)
+{
+  dma_channel_config c = dma_channel_get_default_config(ctrl_ch);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+  channel_config_set_read_increment(&c, false);
+  channel_config_set_write_increment(&c, false);
+  dma_channel_configure(ctrl_ch, &c,
+                        &dma_hw->ch[data_ch].al1_transfer_count_trig,
+                        &rx_dma_reload, 1, false);
+
+  c = dma_channel_get_default_config(data_ch);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+  channel_config_set_read_increment(&c, false);
+  channel_config_set_write_increment(&c, true);
+  channel_config_set_ring(&c, true, __builtin_ctz(size));
+  channel_config_set_dreq(&c, dreq);
+  channel_config_set_chain_to(&c, ctrl_ch);
+  dma_channel_configure(data_ch, &c, buf, src, RX_DMA_RELOAD, true);
+}
+
+static void rx_ring_stop(int data_ch, int ctrl_ch)
+{
+  // Unchain first: aborting a chained channel may trigger its chain.
+  hw_write_masked(&dma_hw->ch[data_ch].al1_ctrl,
+                  (uint32_t)data_ch << DMA_CH0_CTRL_TRIG_CHAIN_TO_LSB,
+                  DMA_CH0_CTRL_TRIG_CHAIN_TO_BITS);
+  dma_channel_abort(data_ch);
+  dma_channel_abort(ctrl_ch);
+}
+
+//--------------------------------------------------------------------+
+// UART bridge
+//--------------------------------------------------------------------+
+// Start sending the next linear part of tx_buf unless tx_ch is busy.
+// Called from the DMA interrupt or with interrupts disabled.
+static void uart_tx_kick(void)
+{
+  if (g_uart.tx_busy) return;
+  uint32_t rd  = g_uart.tx_rd;
+  uint32_t ofs = rd & (UART_TX_SIZE - 1U);
+  uint32_t len = TU_MIN(g_uart.tx_wr - rd, UART_TX_SIZE - ofs);
+  if (!len) return;
+  g_uart.tx_busy = len;
+  dma_channel_transfer_from_buffer_now(g_uart.tx_ch, &g_uart.tx_buf[ofs], len);
+}
+
+static void uart_tx_irq_handler(void)
+{
+  const uint32_t mask = 1u << g_uart.tx_ch;
+  if (!(dma_hw->ints1 & mask)) return;
+  dma_hw->ints1 = mask;
+  g_uart.tx_rd  += g_uart.tx_busy;
+  g_uart.tx_busy = 0;
+  uart_tx_kick();
+}
+
+// The SWO UART program also receives for the PIO UART bridge
+static int swo_uart_offset(void)
+{
+  if (g_swo.offset < 0) {
+    g_swo.offset = pio_add_program(SWO_PIO, &swo_program);
+  }
+  return g_swo.offset;
+}
+
+static void uart_pio_start(uint32_t clkdiv)
+{
+  if (g_uart.tx_offset < 0) {
+    g_uart.tx_offset = pio_add_program(SWO_PIO, &uart_tx_program);
+  }
+  int rx_offset = swo_uart_offset();
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, rx_offset + SWO_PIO_WRAP_TARGET, rx_offset + SWO_PIO_WRAP);
+  sm_config_set_in_pins(&c, UART_RX_PIN);
+  sm_config_set_in_shift(&c, true, false, 32);
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+  sm_config_set_clkdiv_int_frac(&c, (uint16_t)(clkdiv >> 8), (uint8_t)clkdiv);
+  pio_sm_set_consecutive_pindirs(SWO_PIO, UART_RX_SM, UART_RX_PIN, 1, false);
+  pio_gpio_init(SWO_PIO, UART_RX_PIN);
+  pio_sm_init(SWO_PIO, UART_RX_SM, rx_offset + SWO_PIO_OFFSET_START, &c);
+
+  c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, g_uart.tx_offset + UART_PIO_TX_WRAP_TARGET, g_uart.tx_offset + UART_PIO_TX_WRAP);
+  sm_config_set_sideset(&c, UART_PIO_TX_SIDESET_BITS, true, false);
+  sm_config_set_sideset_pins(&c, UART_TX_PIN);
+  sm_config_set_out_pins(&c, UART_TX_PIN, 1);
+  sm_config_set_out_shift(&c, true, false, 32);
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+  sm_config_set_clkdiv_int_frac(&c, (uint16_t)(clkdiv >> 8), (uint8_t)clkdiv);
+  pio_sm_set_pins_with_mask(SWO_PIO, UART_TX_SM, 1u << UART_TX_PIN, 1u << UART_TX_PIN);
+  pio_sm_set_pindirs_with_mask(SWO_PIO, UART_TX_SM, 1u << UART_TX_PIN, 1u << UART_TX_PIN);
+  pio_gpio_init(SWO_PIO, UART_TX_PIN);
+  pio_sm_init(SWO_PIO, UART_TX_SM, g_uart.tx_offset + UART_PIO_TX_WRAP_TARGET, &c);
+
+  pio_set_sm_mask_enabled(SWO_PIO, (1u << UART_RX_SM) | (1u << UART_TX_SM), true);
+}
+
+static void uart_pio_stop(void)
+{
+  pio_set_sm_mask_enabled(SWO_PIO, (1u << UART_RX_SM) | (1u << UART_TX_SM), false);
+  gpio_set_function(UART_TX_PIN, GPIO_FUNC_UART);
+  gpio_set_function(UART_RX_PIN, GPIO_FUNC_UART);
+}
+
+// Attach the rings to the UART or to the PIO state machines.
+// Data still queued for TX is dropped.
+static void uart_bridge_route(bool pio)
+{
+  const volatile void *rx_src;
+  volatile void *tx_dst;
+  uint rx_dreq, tx_dreq;
+
+  if (pio) {
+    // The received byte is in the top byte lane of the FIFO word
+    rx_src  = (const volatile uint8_t *)&SWO_PIO->rxf[UART_RX_SM] + 3;
+    rx_dreq = pio_get_dreq(SWO_PIO, UART_RX_SM, false);
+    tx_dst  = &SWO_PIO->txf[UART_TX_SM];
+    tx_dreq = pio_get_dreq(SWO_PIO, UART_TX_SM, true);
+  } else {
+    rx_src  = &uart_get_hw(UART)->dr;
+    rx_dreq = uart_get_dreq(UART, false);
+    tx_dst  = &uart_get_hw(UART)->dr;
+    tx_dreq = uart_get_dreq(UART, true);
+  }
+
+  // An aborted channel may still raise its interrupt
+  dma_channel_set_irq1_enabled(g_uart.tx_ch, false);
+  dma_channel_abort(g_uart.tx_ch);
+  dma_hw->ints1 = 1u << g_uart.tx_ch;
+  g_uart.tx_busy = 0;
+  g_uart.tx_rd   = g_uart.tx_wr;
+  rx_ring_stop(g_uart.rx_data_ch, g_uart.rx_ctrl_ch);
+
+  if (pio) {
+    uart_pio_start(g_uart.pio_clkdiv);
+  } else if (g_uart.pio) {
+    uart_pio_stop();
+  }
+  g_uart.pio = pio;
+
+  g_uart.rx_rd   = 0;
+  g_uart.rx_used = 0;
+  g_uart.rx_last = RX_DMA_RELOAD;
+  g_uart.rx_overrun = false;
+  rx_ring_start(g_uart.rx_data_ch, g_uart.rx_ctrl_ch, rx_src, rx_dreq, uart_rx_buf, UART_RX_SIZE);
+
+  dma_channel_config c = dma_channel_get_default_config(g_uart.tx_ch);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, tx_dreq);
+  dma_channel_configure(g_uart.tx_ch, &c, tx_dst, g_uart.tx_buf, 0, false);
+  dma_channel_set_irq1_enabled(g_uart.tx_ch, true);
+}
+
+// Apply g_uart.baudrate to the UART, or to the PIO path when the UART
+// divider is too far off.
+//   return: actual baudrate
+static uint32_t uart_bridge_apply(void)
+{
+  uint32_t rate   = g_uart.baudrate;
+  uint32_t actual = uart_set_baudrate(UART, rate);
+  uint32_t div    = 0;
+
+#if (UART_PIO != 0) && (UART_FLOW_CONTROL == 0)
+  uint64_t err = (actual > rate) ? (actual - rate) : (rate - actual);
+  if (g_uart.format_8n1 && ((err * 100U) > ((uint64_t)rate * UART_PIO_TOLERANCE))) {
+    div = swo_pio_clkdiv(clock_get_hz(clk_sys), rate, UART_PIO_CYCLES_PER_BIT);
+  }
+#endif
+  if (!div) {
+    if (g_uart.pio) uart_bridge_route(false);
+    return actual;
+  }
+
+  if (!g_uart.pio) {
+    g_uart.pio_clkdiv = div;
+    uart_bridge_route(true);
+  } else if (g_uart.pio_clkdiv != div) {
+    g_uart.pio_clkdiv = div;
+    pio_sm_set_clkdiv_int_frac(SWO_PIO, UART_RX_SM, (uint16_t)(div >> 8), (uint8_t)div);
+    pio_sm_set_clkdiv_int_frac(SWO_PIO, UART_TX_SM, (uint16_t)(div >> 8), (uint8_t)div);
+    pio_clkdiv_restart_sm_mask(SWO_PIO, (1u << UART_RX_SM) | (1u << UART_TX_SM));
+  }
+  return swo_pio_baudrate(clock_get_hz(clk_sys), div, UART_PIO_CYCLES_PER_BIT);
+}
+
+static void uart_bridge_init(void)
+{
+  g_uart.rx_data_ch = dma_claim_unused_channel(true);
+  g_uart.rx_ctrl_ch = dma_claim_unused_channel(true);
+  g_uart.tx_ch      = dma_claim_unused_channel(true);
+
+  irq_add_shared_handler(UART_TX_IRQ, uart_tx_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  uart_bridge_route(false);
+  irq_set_enabled(UART_TX_IRQ, true);
+}
+
 void board_init(void)
 {
   // UART
@@ -46,6 +343,13 @@ void board_init(void)
   uart_init(UART, 115200);
   gpio_set_pulls(UART_TX_PIN, false, false);
   gpio_pull_up(UART_RX_PIN);
+#if (UART_FLOW_CONTROL != 0)
+  gpio_set_function(UART_CTS_PIN, GPIO_FUNC_UART);
+  gpio_set_function(UART_RTS_PIN, GPIO_FUNC_UART);
+  gpio_pull_up(UART_CTS_PIN);
+  uart_set_hw_flow(UART, true, true);
+#endif
+  uart_bridge_init();
 
   SystemCoreClockUpdate();
 }
@@ -53,62 +357,256 @@ void board_init(void)
 //--------------------------------------------------------------------+
 // Board porting API
 //--------------------------------------------------------------------+
-static int _board_uart_read(uint8_t* buf, int len, uart_inst_t* uart)
+uint32_t board_uart_set_baudrate(unsigned bit_rate)
 {
-  int i;
-  for (i = 0; i < len && uart_is_readable(uart); ++i) {
-    buf[i] = uart_getc(uart);
-  }
-  return i;
+  if (!bit_rate) return 0;
+  g_uart.baudrate = bit_rate;
+  return uart_bridge_apply();
 }
 
-static int _board_uart_write(void const * buf, int len, uart_inst_t* uart)
+int board_uart_set_format(unsigned data_bits, unsigned parity, unsigned stop_bits)
 {
-  char const* p = (char const*)buf;
-  int i;
-  for (i = 0; i < len; ++i) {
-    uart_putc(uart, *p++);
-  }
-  return i;
+  static const uart_parity_t parities[] = {UART_PARITY_NONE, UART_PARITY_ODD, UART_PARITY_EVEN};
+  // Mark/space parity and 1.5 stop bits are not supported
+  if ((data_bits < 5U) || (data_bits > 8U) || (parity > 2U) || (stop_bits == 1U) || (stop_bits > 2U))
+    return 0;
+  uart_set_format(UART, data_bits, stop_bits ? 2U : 1U, parities[parity]);
+  g_uart.format_8n1 = (data_bits == 8U) && !parity && !stop_bits;
+  uart_bridge_apply();
+  return 1;
 }
 
-uint32_t board_uart_set_baudrate(unsigned bit_rate)
+int board_uart_read(uint8_t* buf, int len)
 {
-  return uart_set_baudrate(UART, bit_rate);
+  // The transfer count tells how many bytes arrived, even when DMA has
+  // lapped the reader. In that case skip to the newest data.
+  uint32_t count = dma_channel_hw_addr(g_uart.rx_data_ch)->transfer_count;
+  uint32_t recv  = (count <= g_uart.rx_last) ? (g_uart.rx_last - count) : (g_uart.rx_last + RX_DMA_RELOAD - count);
+  g_uart.rx_last  = count;
+  g_uart.rx_used += recv;
+  if (g_uart.rx_used > UART_RX_SIZE) {
+    g_uart.rx_rd      = (uint32_t)(dma_channel_hw_addr(g_uart.rx_data_ch)->write_addr - (uintptr_t)uart_rx_buf) & (UART_RX_SIZE - 1U);
+    g_uart.rx_used    = 0;
+    g_uart.rx_overrun = true;
+  }
+
+  uint32_t rd  = g_uart.rx_rd;
+  uint32_t n   = TU_MIN((uint32_t)len, g_uart.rx_used);
+  uint32_t lin = TU_MIN(n, UART_RX_SIZE - rd);
+  memcpy(buf, &uart_rx_buf[rd], lin);
+  memcpy(buf + lin, uart_rx_buf, n - lin);
+  g_uart.rx_rd    = (rd + n) & (UART_RX_SIZE - 1U);
+  g_uart.rx_used -= n;
+  return (int)n;
 }
 
-int board_uart_read(uint8_t* buf, int len)
+int board_uart_rx_overrun(void)
 {
-  return _board_uart_read(buf, len, UART);
+  bool overrun = g_uart.rx_overrun;
+  g_uart.rx_overrun = false;
+  return overrun;
 }
 
+// Queue as much of buf as fits without blocking.
 int board_uart_write(void const * buf, int len)
 {
-  return _board_uart_write(buf, len, UART);
+  const uint8_t* src = (const uint8_t*)buf;
+  uint32_t wr  = g_uart.tx_wr;
+  uint32_t n   = TU_MIN((uint32_t)len, UART_TX_SIZE - (wr - g_uart.tx_rd));
+  uint32_t ofs = wr & (UART_TX_SIZE - 1U);
+  uint32_t lin = TU_MIN(n, UART_TX_SIZE - ofs);
+  memcpy(&g_uart.tx_buf[ofs], src, lin);
+  memcpy(g_uart.tx_buf, src + lin, n - lin);
+  g_uart.tx_wr = wr + n;
+
+  uint32_t status = save_and_disable_interrupts();
+  uart_tx_kick();
+  restore_interrupts(status);
+  return (int)n;
+}
+
+// Run one of the SWO programs on the SWO state machine.
+//   idle: line level while no trace data is sent
+static void swo_sm_start(int offset, uint32_t wrap_target, uint32_t wrap, uint32_t start, uint32_t clkdiv, bool idle)
+{
+  pio_sm_set_enabled(SWO_PIO, SWO_SM, false);
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, offset + wrap_target, offset + wrap);
+  sm_config_set_in_pins(&c, SWO_RX_PIN);
+  sm_config_set_jmp_pin(&c, SWO_RX_PIN);
+  sm_config_set_in_shift(&c, true, false, 32);
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);
+  sm_config_set_clkdiv_int_frac(&c, (uint16_t)(clkdiv >> 8), (uint8_t)clkdiv);
+
+  gpio_set_pulls(SWO_RX_PIN, idle, !idle);
+  pio_sm_set_consecutive_pindirs(SWO_PIO, SWO_SM, SWO_RX_PIN, 1, false);
+  pio_gpio_init(SWO_PIO, SWO_RX_PIN);
+
+  pio_sm_init(SWO_PIO, SWO_SM, offset + start, &c);
+  pio_sm_set_enabled(SWO_PIO, SWO_SM, true);
+}
+
+static void swo_sm_stop(void)
+{
+  board_swo_stop_capture();
+  pio_sm_set_enabled(SWO_PIO, SWO_SM, false);
+  gpio_set_function(SWO_RX_PIN, GPIO_FUNC_NULL);
+  gpio_pull_down(SWO_RX_PIN);
+}
+
+// Apply a clock divider for bit_rate to the running SWO state machine.
+//   return: achieved bit rate, 0 if out of range
+static uint32_t swo_sm_set_baudrate(uint32_t* clkdiv, unsigned bit_rate, uint32_t cycles_per_bit)
+{
+  uint32_t sys_hz = clock_get_hz(clk_sys);
+  uint32_t div = swo_pio_clkdiv(sys_hz, bit_rate, cycles_per_bit);
+  if (!div) return 0;
+  *clkdiv = div;
+  pio_sm_set_clkdiv_int_frac(SWO_PIO, SWO_SM, (uint16_t)(div >> 8), (uint8_t)div);
+  pio_sm_clkdiv_restart(SWO_PIO, SWO_SM);
+  return swo_pio_baudrate(sys_hz, div, cycles_per_bit);
 }
 
 int board_swo_set_enabled(int enabled)
 {
   if (enabled) {
-    gpio_pull_up(SWO_RX_PIN);
-    gpio_set_function(SWO_RX_PIN, GPIO_FUNC_UART);
-    uint32_t baudrate = uart_init(SWO, g_swo.baudrate);
-    return (0 != baudrate) ? 1 : 0;
+    swo_uart_offset();
+    if (!g_swo.clkdiv) {
+      g_swo.clkdiv = swo_pio_clkdiv(clock_get_hz(clk_sys), 115200, SWO_PIO_CYCLES_PER_BIT);
+    }
+    swo_sm_start(g_swo.offset, SWO_PIO_WRAP_TARGET, SWO_PIO_WRAP, SWO_PIO_OFFSET_START, g_swo.clkdiv, true);
   } else {
-    uart_deinit(SWO);
-    gpio_set_function(SWO_RX_PIN, GPIO_FUNC_NULL);
-    gpio_pull_down(SWO_RX_PIN);
-    return 1;
+    swo_sm_stop();
   }
+  return 1;
 }
 
 uint32_t board_swo_set_baudrate(unsigned bit_rate)
 {
-  g_swo.baudrate = bit_rate;
-  return uart_set_baudrate(SWO, bit_rate);
+  return swo_sm_set_baudrate(&g_swo.clkdiv, bit_rate, SWO_PIO_CYCLES_PER_BIT);
+}
+
+int board_swo_manchester_set_enabled(int enabled)
+{
+  if (enabled) {
+    if (g_swo.manchester_offset < 0) {
+      g_swo.manchester_offset = pio_add_program(SWO_PIO, &swo_manchester_program);
+    }
+    if (!g_swo.manchester_clkdiv) {
+      g_swo.manchester_clkdiv = swo_pio_clkdiv(clock_get_hz(clk_sys), 115200, SWO_MANCHESTER_PIO_CYCLES_PER_BIT);
+    }
+    swo_sm_start(g_swo.manchester_offset, SWO_MANCHESTER_PIO_WRAP_TARGET, SWO_MANCHESTER_PIO_WRAP,
+                 SWO_MANCHESTER_PIO_OFFSET_START, g_swo.manchester_clkdiv, false);
+  } else {
+    swo_sm_stop();
+  }
+  return 1;
+}
+
+uint32_t board_swo_manchester_set_baudrate(unsigned bit_rate)
+{
+  return swo_sm_set_baudrate(&g_swo.manchester_clkdiv, bit_rate, SWO_MANCHESTER_PIO_CYCLES_PER_BIT);
 }
 
 int board_swo_read(uint8_t* buf, int len)
 {
-  return _board_uart_read(buf, len, SWO);
+  int i;
+  for (i = 0; i < len && !pio_sm_is_rx_fifo_empty(SWO_PIO, SWO_SM); ++i) {
+    buf[i] = swo_pio_read_value(pio_sm_get(SWO_PIO, SWO_SM));
+  }
+  return i;
+}
+
+int board_swo_start_capture(uint8_t* buf, unsigned size)
+{
+  if (g_swo.data_ch < 0) {
+    g_swo.data_ch = dma_claim_unused_channel(true);
+    g_swo.ctrl_ch = dma_claim_unused_channel(true);
+  }
+  board_swo_stop_capture();
+
+  // The received byte is in the top byte lane of the FIFO word
+  const volatile uint8_t *rxf = (const volatile uint8_t *)&SWO_PIO->rxf[SWO_SM] + 3;
+  SWO_PIO->fdebug = 1u << (PIO_FDEBUG_RXSTALL_LSB + SWO_SM);
+  g_swo.last = RX_DMA_RELOAD;
+  rx_ring_start(g_swo.data_ch, g_swo.ctrl_ch, rxf, pio_get_dreq(SWO_PIO, SWO_SM, false), buf, size);
+  return 1;
+}
+
+void board_swo_stop_capture(void)
+{
+  if (g_swo.data_ch < 0) return;
+  rx_ring_stop(g_swo.data_ch, g_swo.ctrl_ch);
+}
+
+unsigned board_swo_captured(bool* overrun)
+{
+  if (g_swo.data_ch < 0) return 0;
+
+  uint32_t count = dma_channel_hw_addr(g_swo.data_ch)->transfer_count;
+  uint32_t n = (count <= g_swo.last) ? (g_swo.last - count) : (g_swo.last + RX_DMA_RELOAD - count);
+  g_swo.last = count;
+
+  // The state machine stalls on a full FIFO only if DMA was held off
+  const uint32_t stall = 1u << (PIO_FDEBUG_RXSTALL_LSB + SWO_SM);
+  if (SWO_PIO->fdebug & stall) {
+    SWO_PIO->fdebug = stall;
+    *overrun = true;
+  }
+  return n;
+}
+
+void board_multicore_launch(void (*entry)(void))
+{
+  multicore_launch_core1(entry);
+}
+
+// CRC-32 by the DMA sniffer.
+// A channel copies buf byte by byte to a dummy location while the sniffer
+// computes the CRC on bit-reversed data. The accumulator is read through
+// the output reverse and inversion, which turns it into the zlib CRC.
+static struct {
+  int     ch;
+  uint8_t sink;
+} g_crc = {
+  .ch = -1,
+};
+
+static uint32_t bitrev32(uint32_t v)
+{
+  v = ((v >> 1) & 0x55555555U) | ((v & 0x55555555U) << 1);
+  v = ((v >> 2) & 0x33333333U) | ((v & 0x33333333U) << 2);
+  v = ((v >> 4) & 0x0F0F0F0FU) | ((v & 0x0F0F0F0FU) << 4);
+  return __builtin_bswap32(v);
+}
+
+uint32_t board_crc32_update(uint32_t crc, void const * buf, unsigned len)
+{
+  if (!len) return crc;
+  if (g_crc.ch < 0) {
+    g_crc.ch = dma_claim_unused_channel(false);
+    if (g_crc.ch < 0) return crc32_update(crc, buf, len);
+  }
+  dma_channel_config c = dma_channel_get_default_config(g_crc.ch);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_sniff_enable(&c, true);
+  dma_channel_configure(g_crc.ch, &c, &g_crc.sink, buf, len, false);
+
+  dma_sniffer_enable(g_crc.ch, DMA_SNIFF_CTRL_CALC_VALUE_CRC32R, true);
+  dma_sniffer_set_output_reverse_enabled(true);
+  dma_sniffer_set_output_invert_enabled(true);
+  dma_sniffer_set_data_accumulator(bitrev32(~crc));
+  dma_channel_start(g_crc.ch);
+  dma_channel_wait_for_finish_blocking(g_crc.ch);
+  crc = dma_sniffer_get_data_accumulator();
+  dma_sniffer_disable();
+  return crc;
+}
+
+uint32_t board_millis(void)
+{
+  return (uint32_t)(time_us_64() / 1000U);
 }
@@ -0,0 +1,352 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+// JTAG backend driven by a PIO state machine.
+// This replaces lib/CMSIS-DAP/Firmware/Source/JTAG_DP.c on RP2040.
+
+#include "swj_pio.h"
+#include "jtag_pio.h"
+
+#if (DAP_JTAG != 0)
+
+#define JTAG_PIO_FIFO_DEPTH   4U
+
+static const pio_program_t jtag_program = {
+  .instructions = jtag_program_instructions,
+  .length       = JTAG_PIO_PROGRAM_LENGTH,
+  .origin       = -1,
+};
+
+static struct {
+  int      offset;
+  uint32_t pending;     // TDO words not read from RX FIFO yet
+  uint32_t clock;       // DAP_Data.nominal_clock applied to the divider
+} g_jtag = {
+  .offset = -1,
+};
+
+//--------------------------------------------------------------------+
+// Helpers
+//--------------------------------------------------------------------+
+static void jtag_pio_update_clock(void)
+{
+  if (g_jtag.clock == DAP_Data.nominal_clock)
+    return;
+  g_jtag.clock = DAP_Data.nominal_clock;
+  swj_pio_set_clock(JTAG_SM, JTAG_PIO_CYCLES_PER_BIT);
+}
+
+// Queue count (1..32) TCK cycles with TMS held and TDI bits LSB first.
+// Every command pushes TDO bits. Unwanted ones are dropped lazily so that
+// commands can be queued without waiting for each of them.
+static void jtag_pio_put(uint32_t tms, uint32_t count, uint32_t tdi)
+{
+  if (g_jtag.pending >= JTAG_PIO_FIFO_DEPTH) {
+    (void)pio_sm_get_blocking(SWJ_PIO, JTAG_SM);
+    --g_jtag.pending;
+  }
+  pio_sm_put_blocking(SWJ_PIO, JTAG_SM, jtag_pio_cmd(g_jtag.offset, tms, count));
+  pio_sm_put_blocking(SWJ_PIO, JTAG_SM, tdi);
+  ++g_jtag.pending;
+}
+
+// Wait for all queued commands.
+static void jtag_pio_flush(void)
+{
+  while (g_jtag.pending) {
+    (void)pio_sm_get_blocking(SWJ_PIO, JTAG_SM);
+    --g_jtag.pending;
+  }
+}
+
+// Shift count (1..32) bits and return TDO bits.
+static uint32_t jtag_pio_shift(uint32_t tms, uint32_t count, uint32_t tdi)
+{
+  jtag_pio_put(tms, count, tdi);
+  while (g_jtag.pending > 1U) {
+    (void)pio_sm_get_blocking(SWJ_PIO, JTAG_SM);
+    --g_jtag.pending;
+  }
+  --g_jtag.pending;
+  return jtag_pio_read_value(pio_sm_get_blocking(SWJ_PIO, JTAG_SM), count);
+}
+
+// Shift count bits of data. Bits beyond 32 are zero.
+static void jtag_pio_write(uint32_t tms, uint32_t count, uint32_t data)
+{
+  while (count) {
+    uint32_t n = (count > 32U) ? 32U : count;
+    jtag_pio_put(tms, n, data);
+    data = 0U;
+    count -= n;
+  }
+}
+
+// Generate count TCK cycles with TDI high.
+static void jtag_pio_clock(uint32_t tms, uint32_t count)
+{
+  while (count) {
+    uint32_t n = (count > 32U) ? 32U : count;
+    jtag_pio_put(tms, n, 0xFFFFFFFFU);
+    count -= n;
+  }
+}
+
+// Move from Run-Test/Idle to Shift-DR and skip the devices before the selected one.
+static void jtag_pio_enter_shift_dr(void)
+{
+  jtag_pio_clock(1U, 1U);                       // Select-DR-Scan
+  jtag_pio_clock(0U, 2U);                       // Capture-DR, Shift-DR
+  jtag_pio_clock(0U, DAP_Data.jtag_dev.index);  // Bypass before data
+}
+
+// Shift the last 32 data bits and leave Shift-DR through the devices after the selected one.
+//   return: TDO bits
+static uint32_t jtag_pio_exit_shift_dr(uint32_t data)
+{
+  uint32_t n = DAP_Data.jtag_dev.count - DAP_Data.jtag_dev.index - 1U;
+  uint32_t val;
+
+  if (n) {
+    val = jtag_pio_shift(0U, 32U, data);
+    jtag_pio_clock(0U, n - 1U);                 // Bypass after data
+    jtag_pio_clock(1U, 2U);                     // Bypass & Exit1-DR, Update-DR
+  } else {
+    val  = jtag_pio_shift(0U, 31U, data);
+    val |= jtag_pio_shift(1U, 1U, data >> 31) << 31;  // D31 & Exit1-DR
+    jtag_pio_clock(1U, 1U);                     // Update-DR
+  }
+  jtag_pio_clock(0U, 1U);                       // Idle
+  return val;
+}
+
+//--------------------------------------------------------------------+
+// Port API
+//--------------------------------------------------------------------+
+void jtag_pio_setup(void)
+{
+  const uint32_t outputs = (1u << PIN_SWCLK_TCK_BIT) | (1u << PIN_SWDIO_TMS_BIT) | (1u << PIN_TDI_BIT);
+  const uint32_t mask    = outputs | (1u << PIN_TDO_BIT);
+
+  if (g_jtag.offset < 0) {
+    g_jtag.offset = pio_add_program(SWJ_PIO, &jtag_program);
+  }
+  pio_sm_set_enabled(SWJ_PIO, JTAG_SM, false);
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, g_jtag.offset + JTAG_PIO_WRAP_TARGET, g_jtag.offset + JTAG_PIO_WRAP);
+  sm_config_set_sideset(&c, JTAG_PIO_SIDESET_BITS, true, false);
+  sm_config_set_sideset_pins(&c, PIN_SWCLK_TCK_BIT);
+  sm_config_set_out_pins(&c, PIN_TDI_BIT, 1);
+  sm_config_set_set_pins(&c, PIN_SWDIO_TMS_BIT, 1);
+  sm_config_set_in_pins(&c, PIN_TDO_BIT);
+  sm_config_set_out_shift(&c, true, false, 32);
+  sm_config_set_in_shift(&c, true, false, 32);
+
+  // TCK low, TMS and TDI high
+  pio_sm_set_pins_with_mask(SWJ_PIO, JTAG_SM, (1u << PIN_SWDIO_TMS_BIT) | (1u << PIN_TDI_BIT), outputs);
+  pio_sm_set_pindirs_with_mask(SWJ_PIO, JTAG_SM, outputs, mask);
+  pio_gpio_init(SWJ_PIO, PIN_SWCLK_TCK_BIT);
+  pio_gpio_init(SWJ_PIO, PIN_SWDIO_TMS_BIT);
+  pio_gpio_init(SWJ_PIO, PIN_TDI_BIT);
+  pio_gpio_init(SWJ_PIO, PIN_TDO_BIT);
+
+  pio_sm_init(SWJ_PIO, JTAG_SM, g_jtag.offset + JTAG_PIO_OFFSET_GET_NEXT_CMD, &c);
+  g_jtag.pending = 0U;
+  g_jtag.clock = 0U; // force reload
+  jtag_pio_update_clock();
+  pio_sm_set_enabled(SWJ_PIO, JTAG_SM, true);
+}
+
+void jtag_pio_off(void)
+{
+  if (g_jtag.offset < 0) return;
+  jtag_pio_flush();
+  swj_pio_drain(JTAG_SM);
+  pio_sm_set_enabled(SWJ_PIO, JTAG_SM, false);
+  pio_sm_clear_fifos(SWJ_PIO, JTAG_SM);
+  pio_sm_restart(SWJ_PIO, JTAG_SM);
+  g_jtag.pending = 0U;
+}
+
+// Generate SWJ Sequence on TMS. Consecutive equal bits share a command.
+//   count:  sequence bit count
+//   data:   pointer to sequence bit data
+//   return: none
+void jtag_pio_swj_sequence(uint32_t count, const uint8_t *data)
+{
+  uint32_t tms = 0U;
+  uint32_t n = 0U;
+
+  jtag_pio_update_clock();
+  for (uint32_t i = 0U; i < count; ++i) {
+    uint32_t bit = (data[i / 8U] >> (i % 8U)) & 1U;
+    if (n && ((bit != tms) || (n == 32U))) {
+      jtag_pio_clock(tms, n);
+      n = 0U;
+    }
+    tms = bit;
+    ++n;
+  }
+  if (n) {
+    jtag_pio_clock(tms, n);
+  }
+  jtag_pio_flush();
+}
+
+//--------------------------------------------------------------------+
+// JTAG_DP API
+//--------------------------------------------------------------------+
+// Generate JTAG Sequence
+//   info:   sequence information
+//   tdi:    pointer to TDI generated data
+//   tdo:    pointer to TDO captured data
+//   return: none
+void JTAG_Sequence(uint32_t info, const uint8_t *tdi, uint8_t *tdo)
+{
+  uint32_t count = info & JTAG_SEQUENCE_TCK;
+  uint32_t tms   = (info & JTAG_SEQUENCE_TMS) ? 1U : 0U;
+
+  if (count == 0U) {
+    count = 64U;
+  }
+
+  jtag_pio_update_clock();
+  while (count) {
+    uint32_t n = (count > 32U) ? 32U : count;
+    uint32_t val = 0U;
+    for (uint32_t i = 0U; i < ((n + 7U) / 8U); ++i) {
+      val |= (uint32_t)*tdi++ << (8U * i);
+    }
+    if (info & JTAG_SEQUENCE_TDO) {
+      val = jtag_pio_shift(tms, n, val);
+      for (uint32_t i = 0U; i < ((n + 7U) / 8U); ++i) {
+        *tdo++ = (uint8_t)(val >> (8U * i));
+      }
+    } else {
+      jtag_pio_put(tms, n, val);
+    }
+    count -= n;
+  }
+  jtag_pio_flush();
+}
+
+// JTAG Set IR
+//   ir:     IR value
+//   return: none
+void JTAG_IR(uint32_t ir)
+{
+  const uint32_t index  = DAP_Data.jtag_dev.index;
+  const uint32_t length = DAP_Data.jtag_dev.ir_length[index];
+  const uint32_t after  = DAP_Data.jtag_dev.ir_after[index];
+
+  jtag_pio_update_clock();
+  jtag_pio_clock(1U, 2U);                           // Select-DR-Scan, Select-IR-Scan
+  jtag_pio_clock(0U, 2U);                           // Capture-IR, Shift-IR
+  jtag_pio_clock(0U, DAP_Data.jtag_dev.ir_before[index]); // Bypass before data
+  if (after) {
+    jtag_pio_write(0U, length, ir);                 // Set IR bits
+    jtag_pio_clock(0U, after - 1U);                 // Bypass after data
+    jtag_pio_clock(1U, 2U);                         // Bypass & Exit1-IR, Update-IR
+  } else {
+    jtag_pio_write(0U, length - 1U, ir);            // Set IR bits (except last)
+    jtag_pio_put(1U, 1U, ((length - 1U) < 32U) ? (ir >> (length - 1U)) : 0U);  // Last bit & Exit1-IR
+    jtag_pio_clock(1U, 1U);                         // Update-IR
+  }
+  jtag_pio_clock(0U, 1U);                           // Idle
+  jtag_pio_flush();
+}
+
+// JTAG Read IDCODE register
+//   return: value read
+uint32_t JTAG_ReadIDCode(void)
+{
+  uint32_t val;
+
+  jtag_pio_update_clock();
+  jtag_pio_clock(1U, 1U);                           // Select-DR-Scan
+  jtag_pio_clock(0U, 2U);                           // Capture-DR, Shift-DR
+  jtag_pio_clock(0U, DAP_Data.jtag_dev.index);      // Bypass before data
+  val  = jtag_pio_shift(0U, 31U, 0xFFFFFFFFU);      // Read IDCODE bits (except last)
+  val |= jtag_pio_shift(1U, 1U, 1U) << 31;          // Last bit & Exit1-DR
+  jtag_pio_clock(1U, 1U);                           // Update-DR
+  jtag_pio_clock(0U, 1U);                           // Idle
+  jtag_pio_flush();
+  return val;
+}
+
+// JTAG Write ABORT register
+//   data:   value to write
+//   return: none
+void JTAG_WriteAbort(uint32_t data)
+{
+  jtag_pio_update_clock();
+  jtag_pio_enter_shift_dr();
+  jtag_pio_write(0U, 3U, 0U);                       // RnW=0 (Write), A2=0, A3=0
+  (void)jtag_pio_exit_shift_dr(data);
+  jtag_pio_flush();
+}
+
+// JTAG Transfer I/O
+//   request: A[3:2] RnW APnDP
+//   data:    DATA[31:0]
+//   return:  ACK[2:0]
+uint8_t JTAG_Transfer(uint32_t request, uint32_t *data)
+{
+  uint32_t ack;
+  uint32_t val;
+
+  jtag_pio_update_clock();
+  jtag_pio_enter_shift_dr();
+
+  // Set RnW, A2, A3 and read ACK
+  val = jtag_pio_shift(0U, 3U, request >> 1);
+  ack = ((val & 1U) << 1) | ((val >> 1) & 1U) | (val & 4U);
+
+  if (ack != DAP_TRANSFER_OK) {
+    jtag_pio_clock(1U, 2U);                         // Exit1-DR, Update-DR
+    jtag_pio_clock(0U, 1U);                         // Idle
+  } else if (request & DAP_TRANSFER_RnW) {
+    val = jtag_pio_exit_shift_dr(0U);
+    if (data) {
+      *data = val;
+    }
+  } else {
+    (void)jtag_pio_exit_shift_dr(*data);
+  }
+  jtag_pio_flush();
+
+#if (TIMESTAMP_CLOCK != 0U)
+  // Capture Timestamp
+  if (request & DAP_TRANSFER_TIMESTAMP) {
+    DAP_Data.timestamp = TIMESTAMP_GET();
+  }
+#endif
+
+  // Idle cycles
+  jtag_pio_clock(0U, DAP_Data.transfer.idle_cycles);
+  jtag_pio_flush();
+
+  return (uint8_t)ack;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#ifndef _JTAG_PIO_H_
+#define _JTAG_PIO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// JTAG PIO program
+//--------------------------------------------------------------------+
+// This header does not depend on pico-sdk so that the host tests can run
+// the same program on a simulator.
+//
+// .program jtag
+// .side_set 1 opt                            ; side-set pin: TCK
+//                                            ; out pin: TDI, set pin: TMS
+//                                            ; in pin:  TDO
+// .wrap_target
+// public get_next_cmd:
+//     pull                         side 0    ; 0: TCK idles low
+//     out x, 8                               ; 1: bit count - 1
+//     out pc, 5                              ; 2: jump to tms_low/tms_high
+// public tms_low:
+//     set pins, 0                            ; 3
+//     jmp load                               ; 4
+// public tms_high:
+//     set pins, 1                            ; 5
+// load:
+//     pull                                   ; 6: fetch TDI bits
+// bitloop:
+//     out pins, 1             [1]  side 0    ; 7: TDI changes on negedge
+//     in pins, 1                   side 1    ; 8: TDO is sampled on posedge
+//     jmp x-- bitloop              side 1    ; 9
+//     push                                   ; 10: TDO bits
+// .wrap
+//
+// TMS is held for the whole command. One TCK period takes 4 PIO cycles.
+
+#define JTAG_PIO_OFFSET_GET_NEXT_CMD  0U
+#define JTAG_PIO_OFFSET_TMS_LOW       3U
+#define JTAG_PIO_OFFSET_TMS_HIGH      5U
+#define JTAG_PIO_WRAP_TARGET          0U
+#define JTAG_PIO_WRAP                 10U
+#define JTAG_PIO_PROGRAM_LENGTH       11U
+#define JTAG_PIO_CYCLES_PER_BIT       4U
+#define JTAG_PIO_SIDESET_BITS         2U  // including the opt bit
+
+static const uint16_t jtag_program_instructions[JTAG_PIO_PROGRAM_LENGTH] = {
+  0x90a0, //  0: pull   block           side 0
+  0x6028, //  1: out    x, 8
+  0x60a5, //  2: out    pc, 5
+  0xe000, //  3: set    pins, 0
+  0x0006, //  4: jmp    6
+  0xe001, //  5: set    pins, 1
+  0x80a0, //  6: pull   block
+  0x7101, //  7: out    pins, 1         side 0 [1]
+  0x5801, //  8: in     pins, 1         side 1
+  0x1847, //  9: jmp    x--, 7          side 1
+  0x8020, // 10: push   block
+};
+
+// Build a command word for get_next_cmd.
+//   offset: load address of the program
+//   tms:    TMS level while clocking
+//   count:  number of clock cycles (1..32)
+static inline uint32_t jtag_pio_cmd(unsigned offset, uint32_t tms, uint32_t count)
+{
+  unsigned entry = tms ? JTAG_PIO_OFFSET_TMS_HIGH : JTAG_PIO_OFFSET_TMS_LOW;
+  return ((count - 1U) & 0xFFU) | (((offset + entry) & 0x1FU) << 8);
+}
+
+// Extract TDO bits from an ISR word pushed after count bits (1..32).
+static inline uint32_t jtag_pio_read_value(uint32_t isr, uint32_t count)
+{
+  return isr >> (32U - count);
+}
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _JTAG_PIO_H_ */
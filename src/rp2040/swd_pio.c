@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+// SWD backend driven by a PIO state machine.
+// This replaces lib/CMSIS-DAP/Firmware/Source/SW_DP.c on RP2040.
+
+#include "swj_pio.h"
+#include "swd_pio.h"
+
+#if (DAP_SWD != 0)
+
+static const pio_program_t swd_program = {
+  .instructions = swd_program_instructions,
+  .length       = SWD_PIO_PROGRAM_LENGTH,
+  .origin       = -1,
+};
+
+static struct {
+  int      offset;
+  bool     active;
+  uint32_t clock;       // DAP_Data.nominal_clock applied to the divider
+} g_swd = {
+  .offset = -1,
+};
+
+//--------------------------------------------------------------------+
+// Helpers
+//--------------------------------------------------------------------+
+static void swd_pio_update_clock(void)
+{
+  if (g_swd.clock == DAP_Data.nominal_clock)
+    return;
+  g_swd.clock = DAP_Data.nominal_clock;
+  swj_pio_set_clock(SWD_SM, SWD_PIO_CYCLES_PER_BIT);
+}
+
+// Clock out count bits (1..256) LSB first. Bits beyond 32 are zero.
+static inline void swd_pio_write(uint32_t count, uint32_t data)
+{
+  pio_sm_put_blocking(SWJ_PIO, SWD_SM, swd_pio_cmd(g_swd.offset, SWD_PIO_OFFSET_WRITE_CMD, count, 1U));
+  pio_sm_put_blocking(SWJ_PIO, SWD_SM, data);
+}
+
+// Clock count cycles (1..256) with SWDIO released.
+static inline void swd_pio_turnaround(uint32_t count)
+{
+  pio_sm_put_blocking(SWJ_PIO, SWD_SM, swd_pio_cmd(g_swd.offset, SWD_PIO_OFFSET_WRITE_CMD, count, 0U));
+  pio_sm_put_blocking(SWJ_PIO, SWD_SM, 0U);
+}
+
+// Capture count bits (1..32) LSB first.
+static inline uint32_t swd_pio_read(uint32_t count)
+{
+  pio_sm_put_blocking(SWJ_PIO, SWD_SM, swd_pio_cmd(g_swd.offset, SWD_PIO_OFFSET_READ_CMD, count, 0U));
+  return swd_pio_read_value(pio_sm_get_blocking(SWJ_PIO, SWD_SM), count);
+}
+
+//--------------------------------------------------------------------+
+// Port API
+//--------------------------------------------------------------------+
+void swd_pio_setup(void)
+{
+  const uint32_t mask = (1u << PIN_SWCLK_TCK_BIT) | (1u << PIN_SWDIO_TMS_BIT);
+
+  if (g_swd.offset < 0) {
+    g_swd.offset = pio_add_program(SWJ_PIO, &swd_program);
+  }
+  pio_sm_set_enabled(SWJ_PIO, SWD_SM, false);
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, g_swd.offset + SWD_PIO_WRAP_TARGET, g_swd.offset + SWD_PIO_WRAP);
+  sm_config_set_sideset(&c, SWD_PIO_SIDESET_BITS, true, false);
+  sm_config_set_sideset_pins(&c, PIN_SWCLK_TCK_BIT);
+  sm_config_set_out_pins(&c, PIN_SWDIO_TMS_BIT, 1);
+  sm_config_set_set_pins(&c, PIN_SWDIO_TMS_BIT, 1);
+  sm_config_set_in_pins(&c, PIN_SWDIO_TMS_BIT);
+  sm_config_set_out_shift(&c, true, false, 32);
+  sm_config_set_in_shift(&c, true, false, 32);
+
+  // SWCLK low, SWDIO high, both driven
+  pio_sm_set_pins_with_mask(SWJ_PIO, SWD_SM, 1u << PIN_SWDIO_TMS_BIT, mask);
+  pio_sm_set_pindirs_with_mask(SWJ_PIO, SWD_SM, mask, mask);
+  pio_gpio_init(SWJ_PIO, PIN_SWCLK_TCK_BIT);
+  pio_gpio_init(SWJ_PIO, PIN_SWDIO_TMS_BIT);
+
+  pio_sm_init(SWJ_PIO, SWD_SM, g_swd.offset + SWD_PIO_OFFSET_GET_NEXT_CMD, &c);
+  g_swd.clock = 0U; // force reload
+  swd_pio_update_clock();
+  pio_sm_set_enabled(SWJ_PIO, SWD_SM, true);
+  g_swd.active = true;
+}
+
+void swd_pio_off(void)
+{
+  if (!g_swd.active) return;
+  swj_pio_drain(SWD_SM);
+  pio_sm_set_enabled(SWJ_PIO, SWD_SM, false);
+  pio_sm_clear_fifos(SWJ_PIO, SWD_SM);
+  pio_sm_restart(SWJ_PIO, SWD_SM);
+  g_swd.active = false;
+}
+
+//--------------------------------------------------------------------+
+// SW_DP API
+//--------------------------------------------------------------------+
+// Generate SWJ Sequence
+//   count:  sequence bit count
+//   data:   pointer to sequence bit data
+//   return: none
+void SWJ_Sequence(uint32_t count, const uint8_t *data)
+{
+#if (DAP_JTAG != 0)
+  if (DAP_Data.debug_port == DAP_PORT_JTAG) {
+    jtag_pio_swj_sequence(count, data);
+    return;
+  }
+#endif
+  if (!g_swd.active) return;
+
+  swd_pio_update_clock();
+  while (count) {
+    uint32_t n = (count > 32U) ? 32U : count;
+    uint32_t val = 0U;
+    for (uint32_t i = 0U; i < ((n + 7U) / 8U); ++i) {
+      val |= (uint32_t)*data++ << (8U * i);
+    }
+    swd_pio_write(n, val);
+    count -= n;
+  }
+}
+
+// Generate SWD Sequence
+//   info:   sequence information
+//   swdo:   pointer to SWDIO generated data
+//   swdi:   pointer to SWDIO captured data
+//   return: none
+void SWD_Sequence(uint32_t info, const uint8_t *swdo, uint8_t *swdi)
+{
+  uint32_t count = info & SWD_SEQUENCE_CLK;
+  if (count == 0U) {
+    count = 64U;
+  }
+  if (!g_swd.active) return;
+
+  swd_pio_update_clock();
+  if (info & SWD_SEQUENCE_DIN) {
+    while (count) {
+      uint32_t n = (count > 32U) ? 32U : count;
+      uint32_t val = swd_pio_read(n);
+      for (uint32_t i = 0U; i < ((n + 7U) / 8U); ++i) {
+        *swdi++ = (uint8_t)(val >> (8U * i));
+      }
+      count -= n;
+    }
+  } else {
+    SWJ_Sequence(count, swdo);
+  }
+}
+
+// SWD Transfer I/O
+//   request: A[3:2] RnW APnDP
+//   data:    DATA[31:0]
+//   return:  ACK[2:0]
+uint8_t SWD_Transfer(uint32_t request, uint32_t *data)
+{
+  const uint32_t turnaround = DAP_Data.swd_conf.turnaround;
+  uint32_t ack;
+  uint32_t val;
+  uint32_t parity;
+
+  swd_pio_update_clock();
+
+  // Packet Request: Start, APnDP, RnW, A2, A3, Parity, Stop, Park
+  val = request & 0x0FU;
+  parity = __builtin_parity(val);
+  swd_pio_write(8U, 0x81U | (val << 1) | (parity << 5));
+
+  // Turnaround and Acknowledge
+  swd_pio_turnaround(turnaround);
+  ack = swd_pio_read(3U);
+
+  if (ack == DAP_TRANSFER_OK) {
+    if (request & DAP_TRANSFER_RnW) {
+      // Read data and parity
+      val    = swd_pio_read(32U);
+      parity = swd_pio_read(1U);
+      swd_pio_turnaround(turnaround);
+      if (parity != (uint32_t)__builtin_parity(val)) {
+        ack = DAP_TRANSFER_ERROR;
+      }
+      if (data) {
+        *data = val;
+      }
+#if (TIMESTAMP_CLOCK != 0U)
+      if (request & DAP_TRANSFER_TIMESTAMP) {
+        DAP_Data.timestamp = TIMESTAMP_GET();
+      }
+#endif
+    } else {
+      swd_pio_turnaround(turnaround);
+#if (TIMESTAMP_CLOCK != 0U)
+      if (request & DAP_TRANSFER_TIMESTAMP) {
+        DAP_Data.timestamp = TIMESTAMP_GET();
+      }
+#endif
+      // Write data and parity
+      val = *data;
+      swd_pio_write(32U, val);
+      swd_pio_write(1U, __builtin_parity(val));
+    }
+    // Idle cycles
+    if (DAP_Data.transfer.idle_cycles) {
+      swd_pio_write(DAP_Data.transfer.idle_cycles, 0U);
+    }
+    return (uint8_t)ack;
+  }
+
+  if ((ack == DAP_TRANSFER_WAIT) || (ack == DAP_TRANSFER_FAULT)) {
+    // WAIT or FAULT response
+    if (DAP_Data.swd_conf.data_phase && ((request & DAP_TRANSFER_RnW) != 0U)) {
+      swd_pio_turnaround(32U + 1U); // dummy read
+    }
+    swd_pio_turnaround(turnaround);
+    if (DAP_Data.swd_conf.data_phase && ((request & DAP_TRANSFER_RnW) == 0U)) {
+      swd_pio_write(32U + 1U, 0U);  // dummy write
+    }
+    return (uint8_t)ack;
+  }
+
+  // Protocol error: back off data phase
+  swd_pio_turnaround(turnaround + 32U + 1U);
+  return (uint8_t)ack;
+}
+
+#endif
+
+// Wait for the bits queued on either state machine before the pins are
+// driven by other means, e.g. nRESET.
+void swj_pio_wait_idle(void)
+{
+  swj_pio_drain(SWD_SM);
+  swj_pio_drain(JTAG_SM);
+}
@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#ifndef _SWD_PIO_H_
+#define _SWD_PIO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// SWD PIO program
+//--------------------------------------------------------------------+
+// This header does not depend on pico-sdk so that the host tests can run
+// the same program on a simulator.
+//
+// .program swd
+// .side_set 1 opt                            ; side-set pin: SWCLK
+//                                            ; out/in pin:   SWDIO
+// public write_cmd:
+//     pull                                   ; 0: fetch data word
+// write_bitloop:
+//     out pins, 1             [1]  side 0    ; 1: host drives SWDIO on negedge
+//     jmp x-- write_bitloop   [1]  side 1    ; 2: target samples on posedge
+// .wrap_target
+// public get_next_cmd:
+//     pull                         side 0    ; 3: SWCLK idles low
+//     out x, 8                               ; 4: bit count - 1
+//     out pindirs, 1                         ; 5: SWDIO direction
+//     out pc, 5                              ; 6: jump to the routine
+// read_bitloop:
+//     nop                                    ; 7
+// public read_cmd:
+//     in pins, 1              [1]  side 1    ; 8: host samples on posedge
+//     jmp x-- read_bitloop         side 0    ; 9
+//     push                                   ; 10
+// .wrap
+//
+// One SWCLK period takes 4 PIO cycles in both directions.
+
+#define SWD_PIO_OFFSET_WRITE_CMD      0U
+#define SWD_PIO_OFFSET_GET_NEXT_CMD   3U
+#define SWD_PIO_OFFSET_READ_CMD       8U
+#define SWD_PIO_WRAP_TARGET           3U
+#define SWD_PIO_WRAP                  10U
+#define SWD_PIO_PROGRAM_LENGTH        11U
+#define SWD_PIO_CYCLES_PER_BIT        4U
+#define SWD_PIO_SIDESET_BITS          2U  // including the opt bit
+
+static const uint16_t swd_program_instructions[SWD_PIO_PROGRAM_LENGTH] = {
+  0x80a0, //  0: pull   block
+  0x7101, //  1: out    pins, 1         side 0 [1]
+  0x1941, //  2: jmp    x--, 1          side 1 [1]
+  0x90a0, //  3: pull   block           side 0
+  0x6028, //  4: out    x, 8
+  0x6081, //  5: out    pindirs, 1
+  0x60a5, //  6: out    pc, 5
+  0xa042, //  7: nop
+  0x5901, //  8: in     pins, 1         side 1 [1]
+  0x1047, //  9: jmp    x--, 7          side 0
+  0x8020, // 10: push   block
+};
+
+// Build a command word for get_next_cmd.
+//   offset: load address of the program
+//   entry:  SWD_PIO_OFFSET_WRITE_CMD or SWD_PIO_OFFSET_READ_CMD
+//   count:  number of clock cycles (1..256)
+//   output: SWDIO direction while clocking (1: output, 0: input)
+static inline uint32_t swd_pio_cmd(unsigned offset, unsigned entry, uint32_t count, uint32_t output)
+{
+  return ((count - 1U) & 0xFFU) | ((output & 1U) << 8) | (((offset + entry) & 0x1FU) << 9);
+}
+
+// Extract a value from an ISR word pushed by read_cmd after count bits (1..32).
+static inline uint32_t swd_pio_read_value(uint32_t isr, uint32_t count)
+{
+  return isr >> (32U - count);
+}
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _SWD_PIO_H_ */
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#ifndef _SWJ_PIO_H_
+#define _SWJ_PIO_H_
+
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+
+#include "DAP_config.h"
+#include "DAP.h"
+
+// SWD and JTAG state machines share one PIO block
+#define SWJ_PIO       pio0
+#define SWD_SM        0
+#define JTAG_SM       1
+
+// Apply the rate requested by DAP_SWJ_Clock to a state machine whose program
+// takes cycles_per_bit PIO cycles per SWCLK/TCK period.
+// DAP.c keeps the requested rate in DAP_Data.nominal_clock. The fractional
+// divider gets as close to it as it can without running faster. Requests
+// beyond SWJ_PIO_MAX_CLOCK run at SWJ_PIO_MAX_CLOCK.
+static inline void swj_pio_set_clock(uint sm, uint32_t cycles_per_bit)
+{
+  uint32_t hz = DAP_Data.nominal_clock;
+  if (hz == 0U)               hz = DAP_DEFAULT_SWJ_CLOCK;
+  if (hz > SWJ_PIO_MAX_CLOCK) hz = SWJ_PIO_MAX_CLOCK;
+  // Divider in 1/256 steps, rounded up so that we never run faster than requested.
+  uint64_t rate = (uint64_t)hz * cycles_per_bit;
+  uint64_t div  = (((uint64_t)clock_get_hz(clk_sys) << 8) + rate - 1U) / rate;
+  if (div < 0x100U)     div = 0x100U;
+  if (div > 0xFFFFFFU)  div = 0xFFFFFFU;
+  pio_sm_set_clkdiv_int_frac(SWJ_PIO, sm, (uint16_t)(div >> 8), (uint8_t)div);
+}
+
+// Wait until a running state machine has clocked out everything queued in
+// its TX FIFO and stalls for the next command. Transfers are posted, so this
+// must precede anything else that touches the pins.
+static inline void swj_pio_drain(uint sm)
+{
+  const uint32_t stall = 1u << (PIO_FDEBUG_TXSTALL_LSB + sm);
+  if (!(SWJ_PIO->ctrl & (1u << (PIO_CTRL_SM_ENABLE_LSB + sm)))) return;
+  SWJ_PIO->fdebug = stall;
+  while (!pio_sm_is_tx_fifo_empty(SWJ_PIO, sm) || !(SWJ_PIO->fdebug & stall)) {
+    tight_loop_contents();
+  }
+}
+
+// Generate SWJ Sequence on TMS while the JTAG state machine owns the pins
+void jtag_pio_swj_sequence(uint32_t count, const uint8_t *data);
+
+#endif /* _SWJ_PIO_H_ */
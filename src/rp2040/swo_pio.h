@@ -0,0 +1,158 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#ifndef _SWO_PIO_H_
+#define _SWO_PIO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// SWO UART (NRZ) PIO program
+//--------------------------------------------------------------------+
+// This header does not depend on pico-sdk so that the host tests can run
+// the same program on a simulator.
+//
+// .program swo_uart
+//                                            ; in pin: SWO
+// .wrap_target
+// public start:
+//     wait 0 pin 0                           ; 0: start bit
+//     set x, 7                [10]           ; 1: to the middle of bit 0
+// bitloop:
+//     in pins, 1                             ; 2: LSB first
+//     jmp x-- bitloop         [6]            ; 3
+//     wait 1 pin 0                           ; 4: stop bit
+//     push                                   ; 5: byte in ISR[31:24]
+// .wrap
+//
+// One bit takes 8 PIO cycles, so the fastest rate is clk_sys / 8.
+// The stop bit is checked 9.5 bits after the start edge. A break is
+// received as a single 0x00.
+
+#define SWO_PIO_OFFSET_START          0U
+#define SWO_PIO_WRAP_TARGET           0U
+#define SWO_PIO_WRAP                  5U
+#define SWO_PIO_PROGRAM_LENGTH        6U
+#define SWO_PIO_CYCLES_PER_BIT        8U
+
+static const uint16_t swo_program_instructions[SWO_PIO_PROGRAM_LENGTH] = {
+  0x2020, //  0: wait   0 pin, 0
+  0xea27, //  1: set    x, 7                   [10]
+  0x4001, //  2: in     pins, 1
+  0x0642, //  3: jmp    x--, 2                 [6]
+  0x20a0, //  4: wait   1 pin, 0
+  0x8020, //  5: push   block
+};
+
+// Clock divider in 1/256 steps for baudrate, rounded to nearest.
+//   cycles_per_bit: PIO cycles per bit of the program
+//   return: 0 if baudrate is out of range
+static inline uint32_t swo_pio_clkdiv(uint32_t sys_hz, uint32_t baudrate, uint32_t cycles_per_bit)
+{
+  uint64_t rate = (uint64_t)baudrate * cycles_per_bit;
+  if ((baudrate == 0U) || (rate > sys_hz)) return 0U;
+  uint64_t div = (((uint64_t)sys_hz << 8) + rate / 2U) / rate;
+  return (div > 0xFFFFFFU) ? 0U : (uint32_t)div;
+}
+
+// Baudrate achieved with a clock divider in 1/256 steps.
+static inline uint32_t swo_pio_baudrate(uint32_t sys_hz, uint32_t div, uint32_t cycles_per_bit)
+{
+  uint64_t den = (uint64_t)div * cycles_per_bit;
+  return (uint32_t)((((uint64_t)sys_hz << 8) + den / 2U) / den);
+}
+
+// Extract the received byte from an ISR word pushed by either program.
+static inline uint8_t swo_pio_read_value(uint32_t isr)
+{
+  return (uint8_t)(isr >> 24);
+}
+
+//--------------------------------------------------------------------+
+// SWO Manchester PIO program
+//--------------------------------------------------------------------+
+// A 1 is sent as high then low, a 0 as low then high. The line idles low.
+// A packet is a start bit (1) followed by data bytes LSB first, and ends
+// with the line idle for at least one bit.
+// The bit clock is recovered from the edge in the middle of every bit.
+//
+// .program swo_manchester
+//                                            ; in pin, jmp pin: SWO
+// .wrap_target
+// public start:
+//     wait 1 pin 0                           ;  0: start bit
+//     set y, 8                               ;  1: no bits in ISR yet
+// one:
+//     wait 0 pin 0                           ;  2: middle of a 1
+// edge:
+//     jmp y-- delay                          ;  3
+//     push                                   ;  4: byte in ISR[31:24]
+//     set y, 7                               ;  5
+// sample:
+//     nop                     [6]            ;  6: 11 cycles after the edge
+//     in pins, 1                             ;  7: first half is the bit value
+//     jmp pin one                            ;  8
+//     set x, 4                               ;  9: a 0 rises in its middle
+// zero:
+//     jmp pin edge                           ; 10
+//     jmp x-- zero                           ; 11
+//     mov isr, null                          ; 12: end of packet, drop partial byte
+// .wrap
+// delay:
+//     jmp sample              [1]            ; 13: as long as push and set
+//
+// One bit takes 16 PIO cycles, so the fastest rate is clk_sys / 16.
+// The end of a packet is detected before a start bit which follows one idle
+// bit can arrive.
+
+#define SWO_MANCHESTER_PIO_OFFSET_START     0U
+#define SWO_MANCHESTER_PIO_WRAP_TARGET      0U
+#define SWO_MANCHESTER_PIO_WRAP             12U
+#define SWO_MANCHESTER_PIO_PROGRAM_LENGTH   14U
+#define SWO_MANCHESTER_PIO_CYCLES_PER_BIT   16U
+
+static const uint16_t swo_manchester_program_instructions[SWO_MANCHESTER_PIO_PROGRAM_LENGTH] = {
+  0x20a0, //  0: wait   1 pin, 0
+  0xe048, //  1: set    y, 8
+  0x2020, //  2: wait   0 pin, 0
+  0x008d, //  3: jmp    y--, 13
+  0x8020, //  4: push   block
+  0xe047, //  5: set    y, 7
+  0xa642, //  6: nop                           [6]
+  0x4001, //  7: in     pins, 1
+  0x00c2, //  8: jmp    pin, 2
+  0xe024, //  9: set    x, 4
+  0x00c3, // 10: jmp    pin, 3
+  0x004a, // 11: jmp    x--, 10
+  0xa0c3, // 12: mov    isr, null
+  0x0106, // 13: jmp    6                      [1]
+};
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _SWO_PIO_H_ */
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+
+#ifndef _UART_PIO_H_
+#define _UART_PIO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+//--------------------------------------------------------------------+
+// UART TX PIO program
+//--------------------------------------------------------------------+
+// This header does not depend on pico-sdk so that the host tests can run
+// the same program on a simulator.
+// The UART bridge receives with the SWO UART program in swo_pio.h, which
+// takes the same 8 PIO cycles per bit.
+//
+// .program uart_tx
+// .side_set 1 opt                            ; side-set pin, out pin: TX
+// .wrap_target
+//     pull                    [7]  side 1    ; 0: stop bit, or idle
+//     set x, 7                [7]  side 0    ; 1: start bit
+// bitloop:
+//     out pins, 1                            ; 2: LSB first
+//     jmp x-- bitloop         [6]            ; 3
+// .wrap
+//
+// Sends 8N1 frames of the low byte of each FIFO word. One bit takes 8 PIO
+// cycles, so the fastest rate is clk_sys / 8.
+
+#define UART_PIO_TX_WRAP_TARGET       0U
+#define UART_PIO_TX_WRAP              3U
+#define UART_PIO_TX_PROGRAM_LENGTH    4U
+#define UART_PIO_TX_SIDESET_BITS      2U  // including the opt bit
+#define UART_PIO_CYCLES_PER_BIT       8U
+
+static const uint16_t uart_tx_program_instructions[UART_PIO_TX_PROGRAM_LENGTH] = {
+  0x9fa0, //  0: pull   block           side 1 [7]
+  0xf727, //  1: set    x, 7            side 0 [7]
+  0x6001, //  2: out    pins, 1
+  0x0642, //  3: jmp    x--, 2                 [6]
+};
+
+#ifdef __cplusplus
+ }
+#endif
+
+#endif /* _UART_PIO_H_ */
@@ -99,6 +99,13 @@
 #define CFG_TUD_CDC_RX_BUFSIZE    (TUD_OPT_HIGH_SPEED ? 512 : 64)
 #define CFG_TUD_CDC_TX_BUFSIZE    (TUD_OPT_HIGH_SPEED ? 512 : 64)
 
+// CDC bridge flush policy. UART data is sent to the host when a full
+// packet is queued, when the line has been idle for CDC_FLUSH_IDLE_CHARS
+// character times, or at the latest CDC_FLUSH_LATENCY_MS after the oldest
+// queued byte arrived.
+#define CDC_FLUSH_IDLE_CHARS      4
+#define CDC_FLUSH_LATENCY_MS      8
+
 // Vendor FIFO size of TX and RX
 // If not configured vendor endpoints will not be buffered
 #define CFG_TUD_VENDOR_RX_BUFSIZE (TUD_OPT_HIGH_SPEED ? 512 * 2 : 64 * 2)
@@ -272,25 +272,77 @@ typedef struct TU_ATTR_PACKED {
     .ep_swo = TUD_BULK_EP_DESCRIPTOR_STRUCT(_epswo, _epsize) \
   }
 
-const cmsis_dap_cfg_desc_t desc_fs_configuration = {
-  // Config number, interface count, string index, total length, attribute, power in mA
-  .config = TUD_CONFIG_DESCRIPTOR_STRUCT(1, ITF_NUM_TOTAL, 0, sizeof(cmsis_dap_cfg_desc_t), TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
-  // Interface number, string index, EP notification address and size, EP data address (out, in) and size.
-  .cdc_acm = TUD_CDC_DESCRIPTOR_STRUCT(ITF_NUM_CDC, 4, 0x81, 8, EPNUM_CDC_OUT, 0x80 | EPNUM_CDC_IN, TUD_OPT_HIGH_SPEED ? 512 : 64),
-  // Interface number, string index, EP dap address(out, in), EP swo address if needed and size.
-  .cmsis_dap_v2 = TUD_CMSIS_DAP_DESCRIPTOR_STRUCT(ITF_NUM_VENDOR, 5, EPNUM_DAP_OUT, 0x80 | EPNUM_DAP_IN,
+// Interface number, string index, EP dap address(out, in), EP swo address if needed and size.
 #if (SWO_STREAM!=0)
-    0x80 | EPNUM_SWO_IN,
+#define CMSIS_DAP_V2_DESC_STRUCT(_epsize) \
+  TUD_CMSIS_DAP_DESCRIPTOR_STRUCT(ITF_NUM_VENDOR, 5, EPNUM_DAP_OUT, 0x80 | EPNUM_DAP_IN, 0x80 | EPNUM_SWO_IN, _epsize)
+#else
+#define CMSIS_DAP_V2_DESC_STRUCT(_epsize) \
+  TUD_CMSIS_DAP_DESCRIPTOR_STRUCT(ITF_NUM_VENDOR, 5, EPNUM_DAP_OUT, 0x80 | EPNUM_DAP_IN, _epsize)
 #endif
-  TUD_OPT_HIGH_SPEED ? 512 : 64)
+
+// Configuration for a given bulk endpoint size
+#define CMSIS_DAP_CFG_DESC_STRUCT(_epsize) \
+  { \
+    /* Config number, interface count, string index, total length, attribute, power in mA */ \
+    .config = TUD_CONFIG_DESCRIPTOR_STRUCT(1, ITF_NUM_TOTAL, 0, sizeof(cmsis_dap_cfg_desc_t), TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100), \
+    /* Interface number, string index, EP notification address and size, EP data address (out, in) and size. */ \
+    .cdc_acm = TUD_CDC_DESCRIPTOR_STRUCT(ITF_NUM_CDC, 4, 0x81, 8, EPNUM_CDC_OUT, 0x80 | EPNUM_CDC_IN, _epsize), \
+    .cmsis_dap_v2 = CMSIS_DAP_V2_DESC_STRUCT(_epsize) \
+  }
+
+const cmsis_dap_cfg_desc_t desc_fs_configuration = CMSIS_DAP_CFG_DESC_STRUCT(64);
+
+#if TUD_OPT_HIGH_SPEED
+const cmsis_dap_cfg_desc_t desc_hs_configuration = CMSIS_DAP_CFG_DESC_STRUCT(512);
+
+// Configuration of the speed not in use, reported as other speed configuration
+static cmsis_dap_cfg_desc_t desc_other_speed_config;
+
+tusb_desc_device_qualifier_t const desc_device_qualifier =
+{
+  .bLength            = sizeof(tusb_desc_device_qualifier_t),
+  .bDescriptorType    = TUSB_DESC_DEVICE_QUALIFIER,
+  .bcdUSB             = 0x0210,
+
+  .bDeviceClass       = TUSB_CLASS_MISC,
+  .bDeviceSubClass    = MISC_SUBCLASS_COMMON,
+  .bDeviceProtocol    = MISC_PROTOCOL_IAD,
+
+  .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+  .bNumConfigurations = 0x01,
+  .bReserved          = 0x00
 };
 
+// Invoked when received GET DEVICE QUALIFIER DESCRIPTOR request
+uint8_t const* tud_descriptor_device_qualifier_cb(void)
+{
+  return (uint8_t const*) &desc_device_qualifier;
+}
+
+// Invoked when received GET OTHER SPEED CONFIGURATION DESCRIPTOR request
+uint8_t const* tud_descriptor_other_speed_configuration_cb(uint8_t index)
+{
+  (void) index;
+  memcpy(&desc_other_speed_config,
+         (tud_speed_get() == TUSB_SPEED_HIGH) ? &desc_fs_configuration : &desc_hs_configuration,
+         sizeof(desc_other_speed_config));
+  desc_other_speed_config.config.bDescriptorType = TUSB_DESC_OTHER_SPEED_CONFIG;
+  return (uint8_t const*) &desc_other_speed_config;
+}
+#endif
+
 // Invoked when received GET CONFIGURATION DESCRIPTOR
 // Application return pointer to descriptor
 // Descriptor contents must exist long enough for transfer to complete
 uint8_t const * tud_descriptor_configuration_cb(uint8_t index)
 {
   (void) index; // for multiple configurations
+#if TUD_OPT_HIGH_SPEED
+  // Bulk endpoints are 512 bytes on high speed and 64 bytes on full speed
+  if (tud_speed_get() == TUSB_SPEED_HIGH)
+    return (uint8_t const*)&desc_hs_configuration;
+#endif
   return (uint8_t const*)&desc_fs_configuration;
 }
 
@@ -3,5 +3,10 @@
 
 #define DAP_PACKET_SIZE      1088
 #define DAP_PACKET_COUNT     4
+#define SWO_UART             1
+#define SWO_BUFFER_SIZE      4096
+#define SWO_STREAM           1
+#define SWO_STREAM_BLOCK_SIZE 512
+#define SWO_STREAM_TIMEOUT   50
 
 #endif /* __DAP_CONFIG_H__ */
@@ -2,11 +2,24 @@
 #include "tusb.h"
 #include "cmsis_dap_device.h"
 #include "mock_tinyusb.h"
+#include "usb_descriptors.h"
+extern "C" {
+#include "DAP_config.h"
+#include "DAP.h"
+}
 
+using ::testing::_;
 using ::testing::DoAll;
+using ::testing::NiceMock;
+using ::testing::SaveArg;
 using ::testing::SetArgPointee;
 using ::testing::Return;
 
+static uint32_t g_swo_transport = 0;
+extern "C" uint32_t SWO_GetTransportMode(void) { return g_swo_transport; }
+static unsigned g_swo_overruns = 0;
+extern "C" void tud_cmsis_dap_swo_overrun_cb(uint8_t) { ++g_swo_overruns; }
+
 TEST(Class, open)
 {
   MockTinyUsb mtu;
@@ -35,3 +48,500 @@ TEST(Class, open)
             cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&itf_desc[0]), sizeof(itf_desc))
             );
 }
+
+TEST(Class, queued_commands_are_tracked_on_arrival)
+{
+  NiceMock<MockTinyUsb> mtu;
+  enum { ITF_NUM_VENDOR = 0, ITF_NUM_TOTAL };
+  enum { EPNUM_VENDOR_IN = 5, EPNUM_VENDOR_OUT = 5};
+  uint8_t rhport = 0;
+  uint8_t const itf_desc[] = {
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 5, EPNUM_VENDOR_OUT, 0x80 | EPNUM_VENDOR_IN, 64)
+  };
+  uint8_t *epout = nullptr;
+  const uint8_t *p_req;
+
+  mtu_set_instance(&mtu);
+  ON_CALL(mtu, usbd_open_edpt_pair)
+    .WillByDefault(DoAll(SetArgPointee<4>(EPNUM_VENDOR_OUT),
+                         SetArgPointee<5>(0x80 | EPNUM_VENDOR_IN),
+                         Return(true)));
+  ON_CALL(mtu, usbd_edpt_xfer)
+    .WillByDefault(DoAll(SaveArg<2>(&epout), Return(true)));
+
+  cmsis_dapd_init();
+  cmsis_dapd_reset(rhport);
+  ASSERT_NE(0, cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&itf_desc[0]), sizeof(itf_desc)));
+  ASSERT_NE(nullptr, epout);
+
+  // Queued packets are held on arrival and nothing is ready yet,
+  // whatever the depth of the batch.
+  for (unsigned i = 0; i < DAP_PACKET_COUNT - 1; ++i) {
+    epout[0] = ID_DAP_QueueCommands;
+    epout[1] = (uint8_t)i;
+    cmsis_dapd_xfer_cb(rhport, EPNUM_VENDOR_OUT, XFER_RESULT_SUCCESS, 2);
+    EXPECT_EQ(0u, tud_cmsis_dap_acquire_request_buffer(&p_req));
+  }
+
+  epout[0] = ID_DAP_Info;
+  epout[1] = DAP_PACKET_COUNT - 1;
+  cmsis_dapd_xfer_cb(rhport, EPNUM_VENDOR_OUT, XFER_RESULT_SUCCESS, 2);
+
+  // The whole batch is released as ExecuteCommands in order.
+  for (unsigned i = 0; i < DAP_PACKET_COUNT; ++i) {
+    ASSERT_EQ(2u, tud_cmsis_dap_acquire_request_buffer(&p_req));
+    EXPECT_EQ((i < DAP_PACKET_COUNT - 1) ? ID_DAP_ExecuteCommands : ID_DAP_Info, p_req[0]);
+    EXPECT_EQ(i, p_req[1]);
+    tud_cmsis_dap_release_request_buffer();
+  }
+  EXPECT_EQ(0u, tud_cmsis_dap_acquire_request_buffer(&p_req));
+  mtu_set_instance(nullptr);
+}
+
+TEST(Class, acquire_does_not_depend_on_batch_depth)
+{
+  NiceMock<MockTinyUsb> mtu;
+  enum { ITF_NUM_VENDOR = 0, ITF_NUM_TOTAL };
+  enum { EPNUM_VENDOR_IN = 5, EPNUM_VENDOR_OUT = 5};
+  uint8_t rhport = 0;
+  uint8_t const itf_desc[] = {
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 5, EPNUM_VENDOR_OUT, 0x80 | EPNUM_VENDOR_IN, 64)
+  };
+  uint8_t *epout = nullptr;
+  const uint8_t *p_req;
+
+  mtu_set_instance(&mtu);
+  ON_CALL(mtu, usbd_open_edpt_pair)
+    .WillByDefault(DoAll(SetArgPointee<4>(EPNUM_VENDOR_OUT),
+                         SetArgPointee<5>(0x80 | EPNUM_VENDOR_IN),
+                         Return(true)));
+  ON_CALL(mtu, usbd_edpt_xfer)
+    .WillByDefault(DoAll(SaveArg<2>(&epout), Return(true)));
+
+  cmsis_dapd_init();
+  cmsis_dapd_reset(rhport);
+  ASSERT_NE(0, cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&itf_desc[0]), sizeof(itf_desc)));
+  ASSERT_NE(nullptr, epout);
+
+  for (unsigned depth = 1; depth < DAP_PACKET_COUNT; ++depth) {
+    for (unsigned i = 0; i < depth; ++i) {
+      epout[0] = ID_DAP_QueueCommands;
+      epout[1] = (uint8_t)i;
+      cmsis_dapd_xfer_cb(rhport, EPNUM_VENDOR_OUT, XFER_RESULT_SUCCESS, 2);
+    }
+    epout[0] = ID_DAP_Info;
+    epout[1] = (uint8_t)depth;
+    cmsis_dapd_xfer_cb(rhport, EPNUM_VENDOR_OUT, XFER_RESULT_SUCCESS, 2);
+
+    for (unsigned i = 0; i <= depth; ++i) {
+      ASSERT_EQ(2u, tud_cmsis_dap_acquire_request_buffer(&p_req)) << "depth " << depth;
+      const uint8_t *first = p_req;
+      // Turn the packet back into a queued one. Acquiring again must
+      // neither rescan the packets nor rewrite them.
+      const_cast<uint8_t*>(p_req)[0] = ID_DAP_QueueCommands;
+      for (unsigned n = 0; n < 3; ++n) {
+        ASSERT_EQ(2u, tud_cmsis_dap_acquire_request_buffer(&p_req)) << "depth " << depth;
+        EXPECT_EQ(first, p_req);
+        EXPECT_EQ(ID_DAP_QueueCommands, p_req[0]);
+        EXPECT_EQ(i, p_req[1]);
+      }
+      tud_cmsis_dap_release_request_buffer();
+    }
+    EXPECT_EQ(0u, tud_cmsis_dap_acquire_request_buffer(&p_req));
+  }
+  mtu_set_instance(nullptr);
+}
+
+TEST(Class, request_arena_keeps_packets_across_wrap_around)
+{
+  NiceMock<MockTinyUsb> mtu;
+  enum { ITF_NUM_VENDOR = 0, ITF_NUM_TOTAL };
+  enum { EPNUM_VENDOR_IN = 5, EPNUM_VENDOR_OUT = 5};
+  uint8_t rhport = 0;
+  uint8_t const itf_desc[] = {
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 5, EPNUM_VENDOR_OUT, 0x80 | EPNUM_VENDOR_IN, 512)
+  };
+  uint8_t *epout = nullptr;
+  const uint8_t *p_req;
+
+  mtu_set_instance(&mtu);
+  ON_CALL(mtu, usbd_open_edpt_pair)
+    .WillByDefault(DoAll(SetArgPointee<4>(EPNUM_VENDOR_OUT),
+                         SetArgPointee<5>(0x80 | EPNUM_VENDOR_IN),
+                         Return(true)));
+  ON_CALL(mtu, usbd_edpt_xfer)
+    .WillByDefault(DoAll(SaveArg<2>(&epout), Return(true)));
+
+  cmsis_dapd_init();
+  cmsis_dapd_reset(rhport);
+  ASSERT_NE(0, cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&itf_desc[0]), sizeof(itf_desc)));
+  ASSERT_NE(nullptr, epout);
+
+  // Two packets in flight with sizes that do not divide the arena.
+  const unsigned sizes[] = {DAP_PACKET_SIZE, 3, DAP_PACKET_SIZE / 2 + 1, 17, DAP_PACKET_SIZE - 5};
+  unsigned rx = 0, tx = 0;
+  for (unsigned loop = 0; loop < 40; ++loop) {
+    unsigned size = sizes[rx % TU_ARRAY_SIZE(sizes)];
+    epout[0] = ID_DAP_Info;
+    for (unsigned i = 1; i < size; ++i) epout[i] = (uint8_t)(rx + i);
+    cmsis_dapd_xfer_cb(rhport, EPNUM_VENDOR_OUT, XFER_RESULT_SUCCESS, size);
+    ++rx;
+    if (rx - tx < 2) continue;
+
+    size = sizes[tx % TU_ARRAY_SIZE(sizes)];
+    ASSERT_EQ(size, tud_cmsis_dap_acquire_request_buffer(&p_req));
+    for (unsigned i = 1; i < size; ++i) {
+      ASSERT_EQ((uint8_t)(tx + i), p_req[i]) << "packet " << tx << " byte " << i;
+    }
+    tud_cmsis_dap_release_request_buffer();
+    ++tx;
+  }
+  mtu_set_instance(nullptr);
+}
+
+TEST(Class, queued_commands_filling_arena_are_released)
+{
+  NiceMock<MockTinyUsb> mtu;
+  enum { ITF_NUM_VENDOR = 0, ITF_NUM_TOTAL };
+  enum { EPNUM_VENDOR_IN = 5, EPNUM_VENDOR_OUT = 5};
+  uint8_t rhport = 0;
+  uint8_t const itf_desc[] = {
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 5, EPNUM_VENDOR_OUT, 0x80 | EPNUM_VENDOR_IN, 512)
+  };
+  uint8_t *epout = nullptr;
+  unsigned out_xfers = 0;
+  const uint8_t *p_req;
+
+  mtu_set_instance(&mtu);
+  ON_CALL(mtu, usbd_open_edpt_pair)
+    .WillByDefault(DoAll(SetArgPointee<4>(EPNUM_VENDOR_OUT),
+                         SetArgPointee<5>(0x80 | EPNUM_VENDOR_IN),
+                         Return(true)));
+  ON_CALL(mtu, usbd_edpt_claim(_, EPNUM_VENDOR_OUT))
+    .WillByDefault(Return(true));
+  ON_CALL(mtu, usbd_edpt_xfer(_, EPNUM_VENDOR_OUT, _, _))
+    .WillByDefault(DoAll(SaveArg<2>(&epout),
+                         ::testing::InvokeWithoutArgs([&out_xfers] { ++out_xfers; }),
+                         Return(true)));
+
+  cmsis_dapd_init();
+  cmsis_dapd_reset(rhport);
+  ASSERT_NE(0, cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&itf_desc[0]), sizeof(itf_desc)));
+  ASSERT_NE(nullptr, epout);
+
+  // Move the arena head off zero so that full-size packets cannot wrap.
+  epout[0] = ID_DAP_Info;
+  cmsis_dapd_xfer_cb(rhport, EPNUM_VENDOR_OUT, XFER_RESULT_SUCCESS, 4);
+  ASSERT_EQ(4u, tud_cmsis_dap_acquire_request_buffer(&p_req));
+  tud_cmsis_dap_release_request_buffer();
+
+  // The arena runs out before the packet count does.
+  const unsigned fit = (DAP_PACKET_COUNT * DAP_PACKET_SIZE - 4) / DAP_PACKET_SIZE;
+  ASSERT_LT(fit, (unsigned)DAP_PACKET_COUNT);
+  for (unsigned i = 0; i <= fit; ++i) {
+    epout[0] = ID_DAP_QueueCommands;
+    epout[1] = (uint8_t)i;
+    cmsis_dapd_xfer_cb(rhport, EPNUM_VENDOR_OUT, XFER_RESULT_SUCCESS, DAP_PACKET_SIZE);
+  }
+  const unsigned armed = out_xfers;
+
+  // The batch in the arena is released while the last packet waits for room.
+  for (unsigned i = 0; i < fit; ++i) {
+    ASSERT_EQ((uint32_t)DAP_PACKET_SIZE, tud_cmsis_dap_acquire_request_buffer(&p_req));
+    EXPECT_EQ(ID_DAP_ExecuteCommands, p_req[0]);
+    EXPECT_EQ(i, p_req[1]);
+    tud_cmsis_dap_release_request_buffer();
+  }
+  EXPECT_LT(armed, out_xfers);
+
+  // The batch continues with the waiting packet.
+  EXPECT_EQ(0u, tud_cmsis_dap_acquire_request_buffer(&p_req));
+  epout[0] = ID_DAP_Info;
+  cmsis_dapd_xfer_cb(rhport, EPNUM_VENDOR_OUT, XFER_RESULT_SUCCESS, 2);
+  ASSERT_EQ((uint32_t)DAP_PACKET_SIZE, tud_cmsis_dap_acquire_request_buffer(&p_req));
+  EXPECT_EQ(ID_DAP_ExecuteCommands, p_req[0]);
+  EXPECT_EQ(fit, p_req[1]);
+  tud_cmsis_dap_release_request_buffer();
+  ASSERT_EQ(2u, tud_cmsis_dap_acquire_request_buffer(&p_req));
+  EXPECT_EQ(ID_DAP_Info, p_req[0]);
+  tud_cmsis_dap_release_request_buffer();
+  mtu_set_instance(nullptr);
+}
+
+TEST(Class, packet_size_follows_link_speed)
+{
+  NiceMock<MockTinyUsb> mtu;
+  enum { ITF_NUM_VENDOR = 0, ITF_NUM_TOTAL };
+  enum { EPNUM_VENDOR_IN = 5, EPNUM_VENDOR_OUT = 5};
+  uint8_t rhport = 0;
+  uint8_t const fs_desc[] = {
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 5, EPNUM_VENDOR_OUT, 0x80 | EPNUM_VENDOR_IN, 64)
+  };
+  uint8_t const hs_desc[] = {
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 5, EPNUM_VENDOR_OUT, 0x80 | EPNUM_VENDOR_IN, 512)
+  };
+
+  mtu_set_instance(&mtu);
+  ON_CALL(mtu, usbd_open_edpt_pair)
+    .WillByDefault(DoAll(SetArgPointee<4>(EPNUM_VENDOR_OUT),
+                         SetArgPointee<5>(0x80 | EPNUM_VENDOR_IN),
+                         Return(true)));
+  ON_CALL(mtu, usbd_edpt_xfer).WillByDefault(Return(true));
+
+  cmsis_dapd_init();
+  cmsis_dapd_reset(rhport);
+  EXPECT_CALL(mtu, usbd_edpt_xfer(rhport, EPNUM_VENDOR_OUT, _, 64));
+  ASSERT_NE(0, cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&fs_desc[0]), sizeof(fs_desc)));
+  EXPECT_EQ(64u, tud_cmsis_dap_packet_size());
+
+  cmsis_dapd_reset(rhport);
+  EXPECT_CALL(mtu, usbd_edpt_xfer(rhport, EPNUM_VENDOR_OUT, _, DAP_PACKET_SIZE));
+  ASSERT_NE(0, cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&hs_desc[0]), sizeof(hs_desc)));
+  EXPECT_EQ((uint32_t)DAP_PACKET_SIZE, tud_cmsis_dap_packet_size());
+  mtu_set_instance(nullptr);
+}
+
+TEST(Class, swo_stream_transmits_from_fifo)
+{
+  NiceMock<MockTinyUsb> mtu;
+  enum { ITF_NUM_VENDOR = 0, ITF_NUM_TOTAL };
+  enum { EPNUM_VENDOR_IN = 5, EPNUM_VENDOR_OUT = 5, EPNUM_SWO = 6 };
+  uint8_t rhport = 0;
+  uint8_t const itf_desc[] = {
+    TUD_CMSIS_DAP_DESCRIPTOR(ITF_NUM_VENDOR, 5, EPNUM_VENDOR_OUT, 0x80 | EPNUM_VENDOR_IN, 0x80 | EPNUM_SWO, 64)
+  };
+  static uint8_t trace[2 * SWO_BUFFER_SIZE];
+  uint8_t *p_swo = nullptr;
+
+  for (unsigned i = 0; i < sizeof(trace); ++i) trace[i] = (uint8_t)(i * 7 + (i >> 8));
+
+  mtu_set_instance(&mtu);
+  ON_CALL(mtu, usbd_open_edpt_pair(rhport, _, 2, _, _, _))
+    .WillByDefault(DoAll(SetArgPointee<4>(EPNUM_VENDOR_OUT),
+                         SetArgPointee<5>(0x80 | EPNUM_VENDOR_IN),
+                         Return(true)));
+  ON_CALL(mtu, usbd_open_edpt_pair(rhport, _, 1, _, nullptr, _))
+    .WillByDefault(DoAll(SetArgPointee<5>(0x80 | EPNUM_SWO), Return(true)));
+  ON_CALL(mtu, usbd_edpt_xfer).WillByDefault(Return(true));
+  ON_CALL(mtu, usbd_edpt_claim(_, 0x80 | EPNUM_SWO)).WillByDefault(Return(false));
+
+  cmsis_dapd_init();
+  cmsis_dapd_reset(rhport);
+  ASSERT_NE(0, cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&itf_desc[0]), sizeof(itf_desc)));
+
+  // Move the read pointer near the end of the FIFO while the endpoint is busy
+  uint8_t drop[SWO_BUFFER_SIZE - 300];
+  g_swo_transport = 1;
+  EXPECT_EQ(SWO_BUFFER_SIZE - 100u, tud_cmsis_dap_n_swo_enqueue(0, trace, SWO_BUFFER_SIZE - 100));
+  EXPECT_EQ(sizeof(drop), tud_cmsis_dap_n_swo_dequeue(0, drop, sizeof(drop)));
+  g_swo_transport = 2;
+  // Streaming never overwrites data
+  EXPECT_EQ(SWO_BUFFER_SIZE - 200u, tud_cmsis_dap_n_swo_enqueue(0, &trace[SWO_BUFFER_SIZE - 100], SWO_BUFFER_SIZE));
+  EXPECT_EQ((uint32_t)SWO_BUFFER_SIZE, tud_cmsis_dap_swo_used());
+
+  // Transfers point into the FIFO: first the part up to its end,
+  // then blocks of USB_BLOCK_SIZE.
+  ON_CALL(mtu, usbd_edpt_claim(_, 0x80 | EPNUM_SWO)).WillByDefault(Return(true));
+  EXPECT_CALL(mtu, usbd_edpt_xfer(rhport, 0x80 | EPNUM_SWO, _, 300))
+    .WillOnce(DoAll(SaveArg<2>(&p_swo), Return(true)));
+  tud_cmsis_dap_n_swo_enqueue(0, trace, 0);
+  ASSERT_NE(nullptr, p_swo);
+  EXPECT_EQ(0, memcmp(p_swo, &trace[SWO_BUFFER_SIZE - 300], 300));
+  EXPECT_EQ((uint32_t)SWO_BUFFER_SIZE, tud_cmsis_dap_swo_used());
+
+  EXPECT_CALL(mtu, usbd_edpt_xfer(rhport, 0x80 | EPNUM_SWO, _, 512))
+    .WillOnce(DoAll(SaveArg<2>(&p_swo), Return(true)));
+  cmsis_dapd_xfer_cb(rhport, 0x80 | EPNUM_SWO, XFER_RESULT_SUCCESS, 300);
+  EXPECT_EQ(0, memcmp(p_swo, &trace[SWO_BUFFER_SIZE], 512));
+  EXPECT_EQ(SWO_BUFFER_SIZE - 300u, tud_cmsis_dap_swo_used());
+
+  // Nothing is freed twice if the FIFO is cleared during a transfer
+  tud_cmsis_dap_n_swo_clear(0);
+  EXPECT_CALL(mtu, usbd_edpt_xfer(rhport, 0x80 | EPNUM_SWO, _, _)).Times(0);
+  cmsis_dapd_xfer_cb(rhport, 0x80 | EPNUM_SWO, XFER_RESULT_SUCCESS, 512);
+  EXPECT_EQ(0u, tud_cmsis_dap_swo_used());
+  g_swo_transport = 0;
+  mtu_set_instance(nullptr);
+}
+
+TEST(Class, swo_stream_waits_for_block_or_timeout)
+{
+  NiceMock<MockTinyUsb> mtu;
+  enum { ITF_NUM_VENDOR = 0, ITF_NUM_TOTAL };
+  enum { EPNUM_VENDOR_IN = 5, EPNUM_VENDOR_OUT = 5, EPNUM_SWO = 6 };
+  uint8_t rhport = 0;
+  uint8_t const itf_desc[] = {
+    TUD_CMSIS_DAP_DESCRIPTOR(ITF_NUM_VENDOR, 5, EPNUM_VENDOR_OUT, 0x80 | EPNUM_VENDOR_IN, 0x80 | EPNUM_SWO, 64)
+  };
+  static uint8_t trace[SWO_STREAM_BLOCK_SIZE];
+  tud_cmsis_dap_swo_stats_t stats;
+
+  mtu_set_instance(&mtu);
+  ON_CALL(mtu, usbd_open_edpt_pair(rhport, _, 2, _, _, _))
+    .WillByDefault(DoAll(SetArgPointee<4>(EPNUM_VENDOR_OUT),
+                         SetArgPointee<5>(0x80 | EPNUM_VENDOR_IN),
+                         Return(true)));
+  ON_CALL(mtu, usbd_open_edpt_pair(rhport, _, 1, _, nullptr, _))
+    .WillByDefault(DoAll(SetArgPointee<5>(0x80 | EPNUM_SWO), Return(true)));
+  ON_CALL(mtu, usbd_edpt_xfer).WillByDefault(Return(true));
+  ON_CALL(mtu, usbd_edpt_claim).WillByDefault(Return(true));
+
+  g_swo_transport = 2;
+  cmsis_dapd_init();
+  cmsis_dapd_reset(rhport);
+  ASSERT_NE(0, cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&itf_desc[0]), sizeof(itf_desc)));
+
+  // A partial block is held until the timeout expires
+  EXPECT_CALL(mtu, usbd_edpt_xfer(rhport, 0x80 | EPNUM_SWO, _, _)).Times(0);
+  tud_cmsis_dap_n_swo_enqueue(0, trace, 100);
+  tud_cmsis_dap_swo_task(1000);
+  tud_cmsis_dap_swo_task(1000 + SWO_STREAM_TIMEOUT - 1);
+  ::testing::Mock::VerifyAndClearExpectations(&mtu);
+
+  EXPECT_CALL(mtu, usbd_edpt_xfer(rhport, 0x80 | EPNUM_SWO, _, 100)).WillOnce(Return(true));
+  tud_cmsis_dap_swo_task(1000 + SWO_STREAM_TIMEOUT);
+  cmsis_dapd_xfer_cb(rhport, 0x80 | EPNUM_SWO, XFER_RESULT_SUCCESS, 100);
+  ::testing::Mock::VerifyAndClearExpectations(&mtu);
+
+  // A full block goes out right away
+  EXPECT_CALL(mtu, usbd_edpt_xfer(rhport, 0x80 | EPNUM_SWO, _, SWO_STREAM_BLOCK_SIZE)).WillOnce(Return(true));
+  tud_cmsis_dap_n_swo_enqueue(0, trace, SWO_STREAM_BLOCK_SIZE - 10);
+  tud_cmsis_dap_n_swo_enqueue(0, trace, 10);
+  ::testing::Mock::VerifyAndClearExpectations(&mtu);
+
+  tud_cmsis_dap_swo_stats(&stats);
+  EXPECT_EQ(100u + SWO_STREAM_BLOCK_SIZE, stats.bytes);
+  EXPECT_EQ(2u, stats.transfers);
+  EXPECT_EQ(2u + SWO_STREAM_BLOCK_SIZE / 64, stats.packets);
+  g_swo_transport = 0;
+  mtu_set_instance(nullptr);
+}
+
+TEST(Class, swo_commit_follows_external_writer)
+{
+  uint8_t *buf = nullptr;
+  uint8_t out[16];
+
+  cmsis_dapd_init();
+  cmsis_dapd_reset(0);
+  g_swo_transport = 1;
+  ASSERT_EQ((uint32_t)SWO_BUFFER_SIZE, tud_cmsis_dap_swo_buffer(&buf));
+
+  // Data written into the storage shows up once committed
+  memcpy(buf, "trace", 5);
+  EXPECT_EQ(0u, tud_cmsis_dap_swo_used());
+  EXPECT_EQ(5u, tud_cmsis_dap_swo_commit(5));
+  EXPECT_EQ(5u, tud_cmsis_dap_swo_dequeue(out, sizeof(out)));
+  EXPECT_EQ(0, memcmp(out, "trace", 5));
+
+  // Overrun drops everything and resynchronizes with the writer
+  EXPECT_EQ(0u, tud_cmsis_dap_swo_commit(SWO_BUFFER_SIZE + 3));
+  EXPECT_EQ(0u, tud_cmsis_dap_swo_used());
+  memcpy(&buf[8], "next", 4);
+  EXPECT_EQ(4u, tud_cmsis_dap_swo_commit(4));
+  EXPECT_EQ(4u, tud_cmsis_dap_swo_dequeue(out, sizeof(out)));
+  EXPECT_EQ(0, memcmp(out, "next", 4));
+  g_swo_transport = 0;
+}
+
+TEST(Class, swo_full_buffer_drops_newest_data)
+{
+  static uint8_t trace[SWO_BUFFER_SIZE + 100];
+  static uint8_t out[SWO_BUFFER_SIZE];
+  for (unsigned i = 0; i < sizeof(trace); ++i) trace[i] = (uint8_t)(i * 7 + (i >> 8));
+
+  cmsis_dapd_init();
+  cmsis_dapd_reset(0);
+  g_swo_transport = 1;
+  g_swo_overruns = 0;
+
+  EXPECT_EQ(SWO_BUFFER_SIZE - 10u, tud_cmsis_dap_swo_enqueue(trace, SWO_BUFFER_SIZE - 10));
+  EXPECT_EQ(0u, g_swo_overruns);
+  EXPECT_EQ(10u, tud_cmsis_dap_swo_enqueue(&trace[SWO_BUFFER_SIZE - 10], 110));
+  EXPECT_EQ(1u, g_swo_overruns);
+  EXPECT_EQ((uint32_t)SWO_BUFFER_SIZE, tud_cmsis_dap_swo_dequeue(out, sizeof(out)));
+  EXPECT_EQ(0, memcmp(out, trace, SWO_BUFFER_SIZE));
+  g_swo_transport = 0;
+}
+
+TEST(Class, swo_full_buffer_drops_oldest_data)
+{
+  static uint8_t trace[70000];
+  static uint8_t out[SWO_BUFFER_SIZE];
+  for (unsigned i = 0; i < sizeof(trace); ++i) trace[i] = (uint8_t)(i * 7 + (i >> 8));
+
+  cmsis_dapd_init();
+  cmsis_dapd_reset(0);
+  tud_cmsis_dap_swo_set_overwrite(true);
+  g_swo_transport = 1;
+  g_swo_overruns = 0;
+
+  // Oldest data makes room for the newest
+  EXPECT_EQ(SWO_BUFFER_SIZE - 10u, tud_cmsis_dap_swo_enqueue(trace, SWO_BUFFER_SIZE - 10));
+  EXPECT_EQ(110u, tud_cmsis_dap_swo_enqueue(&trace[SWO_BUFFER_SIZE - 10], 110));
+  EXPECT_EQ(0u, g_swo_overruns);
+  EXPECT_EQ((uint32_t)SWO_BUFFER_SIZE, tud_cmsis_dap_swo_dequeue(out, sizeof(out)));
+  EXPECT_EQ(0, memcmp(out, &trace[100], SWO_BUFFER_SIZE));
+
+  // Lengths beyond 16 bits keep the newest buffer size of data
+  EXPECT_EQ((uint32_t)SWO_BUFFER_SIZE, tud_cmsis_dap_swo_enqueue(trace, sizeof(trace)));
+  EXPECT_EQ(1u, g_swo_overruns);
+  EXPECT_EQ((uint32_t)SWO_BUFFER_SIZE, tud_cmsis_dap_swo_dequeue(out, sizeof(out)));
+  EXPECT_EQ(0, memcmp(out, &trace[sizeof(trace) - SWO_BUFFER_SIZE], SWO_BUFFER_SIZE));
+
+  tud_cmsis_dap_swo_set_overwrite(false);
+  g_swo_transport = 0;
+}
+
+TEST(Class, swo_overwrite_spares_transfer_in_flight)
+{
+  NiceMock<MockTinyUsb> mtu;
+  enum { ITF_NUM_VENDOR = 0, ITF_NUM_TOTAL };
+  enum { EPNUM_VENDOR_IN = 5, EPNUM_VENDOR_OUT = 5, EPNUM_SWO = 6 };
+  uint8_t rhport = 0;
+  uint8_t const itf_desc[] = {
+    TUD_CMSIS_DAP_DESCRIPTOR(ITF_NUM_VENDOR, 5, EPNUM_VENDOR_OUT, 0x80 | EPNUM_VENDOR_IN, 0x80 | EPNUM_SWO, 64)
+  };
+  static uint8_t trace[2 * SWO_BUFFER_SIZE];
+  uint8_t *p_swo = nullptr;
+  for (unsigned i = 0; i < sizeof(trace); ++i) trace[i] = (uint8_t)(i * 7 + (i >> 8));
+
+  mtu_set_instance(&mtu);
+  ON_CALL(mtu, usbd_open_edpt_pair(rhport, _, 2, _, _, _))
+    .WillByDefault(DoAll(SetArgPointee<4>(EPNUM_VENDOR_OUT),
+                         SetArgPointee<5>(0x80 | EPNUM_VENDOR_IN),
+                         Return(true)));
+  ON_CALL(mtu, usbd_open_edpt_pair(rhport, _, 1, _, nullptr, _))
+    .WillByDefault(DoAll(SetArgPointee<5>(0x80 | EPNUM_SWO), Return(true)));
+  ON_CALL(mtu, usbd_edpt_claim).WillByDefault(Return(true));
+  ON_CALL(mtu, usbd_edpt_xfer).WillByDefault(Return(true));
+
+  g_swo_transport = 2;
+  g_swo_overruns = 0;
+  cmsis_dapd_init();
+  cmsis_dapd_reset(rhport);
+  tud_cmsis_dap_swo_set_overwrite(true);
+  ASSERT_NE(0, cmsis_dapd_open(rhport, reinterpret_cast<tusb_desc_interface_t const*>(&itf_desc[0]), sizeof(itf_desc)));
+
+  // The first block is in flight
+  EXPECT_CALL(mtu, usbd_edpt_xfer(rhport, 0x80 | EPNUM_SWO, _, SWO_STREAM_BLOCK_SIZE))
+    .WillOnce(DoAll(SaveArg<2>(&p_swo), Return(true)));
+  EXPECT_EQ((uint32_t)SWO_BUFFER_SIZE, tud_cmsis_dap_swo_enqueue(trace, SWO_BUFFER_SIZE));
+  ASSERT_NE(nullptr, p_swo);
+  ON_CALL(mtu, usbd_edpt_claim).WillByDefault(Return(false));
+
+  // Older data is dropped, but not the block being transmitted
+  EXPECT_EQ(0u, tud_cmsis_dap_swo_enqueue(&trace[SWO_BUFFER_SIZE], 100));
+  EXPECT_EQ(1u, g_swo_overruns);
+  EXPECT_EQ(0, memcmp(p_swo, trace, SWO_STREAM_BLOCK_SIZE));
+
+  // Once sent, its room takes new data
+  cmsis_dapd_xfer_cb(rhport, 0x80 | EPNUM_SWO, XFER_RESULT_SUCCESS, SWO_STREAM_BLOCK_SIZE);
+  EXPECT_EQ(100u, tud_cmsis_dap_swo_enqueue(&trace[SWO_BUFFER_SIZE], 100));
+  EXPECT_EQ(1u, g_swo_overruns);
+  EXPECT_EQ(SWO_BUFFER_SIZE - SWO_STREAM_BLOCK_SIZE + 100u, tud_cmsis_dap_swo_used());
+
+  tud_cmsis_dap_swo_set_overwrite(false);
+  g_swo_transport = 0;
+  mtu_set_instance(nullptr);
+}
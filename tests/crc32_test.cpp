@@ -0,0 +1,34 @@
+#include <cstring>
+#include <vector>
+#include "gtest/gtest.h"
+#include "crc32.h"
+
+TEST(Crc32, check_value)
+{
+  const char* s = "123456789";
+  EXPECT_EQ(0xCBF43926u, crc32_update(CRC32_INIT, s, (uint32_t)strlen(s)));
+}
+
+TEST(Crc32, empty_keeps_crc)
+{
+  EXPECT_EQ(0u, crc32_update(CRC32_INIT, "", 0));
+  EXPECT_EQ(0x12345678u, crc32_update(0x12345678u, "", 0));
+}
+
+TEST(Crc32, erased_word)
+{
+  const uint8_t ff[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+  EXPECT_EQ(0xFFFFFFFFu, crc32_update(CRC32_INIT, ff, 4));
+}
+
+TEST(Crc32, chained_updates_match_one_pass)
+{
+  std::vector<uint8_t> data(1000);
+  for (size_t i = 0; i < data.size(); ++i) data[i] = (uint8_t)(i * 7 + 3);
+  uint32_t whole = crc32_update(CRC32_INIT, data.data(), (uint32_t)data.size());
+  uint32_t crc = CRC32_INIT;
+  crc = crc32_update(crc, data.data(), 1);
+  crc = crc32_update(crc, data.data() + 1, 256);
+  crc = crc32_update(crc, data.data() + 257, (uint32_t)data.size() - 257);
+  EXPECT_EQ(whole, crc);
+}
@@ -0,0 +1,183 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "tusb.h"
+#include "cmsis_dap_device.h"
+#include "dap_executor.h"
+#include "mock_tinyusb.h"
+extern "C" {
+#include "DAP_config.h"
+#include "DAP.h"
+}
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::SaveArg;
+using ::testing::SetArgPointee;
+
+static std::vector<uint8_t> g_executed;
+
+extern "C" uint32_t DAP_ProcessCommand(const uint8_t *request, uint8_t *response)
+{
+  g_executed.push_back(request[0]);
+  response[0] = request[0];
+  if ((request[0] == ID_DAP_Info) && (request[1] == DAP_ID_PACKET_SIZE)) {
+    response[1] = 2;
+    response[2] = (uint8_t)(DAP_PACKET_SIZE >> 0);
+    response[3] = (uint8_t)(DAP_PACKET_SIZE >> 8);
+    return (2U << 16) | 4U;
+  }
+  response[1] = DAP_OK;
+  return (1U << 16) | 2U;
+}
+
+namespace {
+
+enum { ITF_NUM_VENDOR = 0 };
+enum { EP_OUT = 5, EP_IN = 0x85 };
+
+class DapExecutor : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    const uint8_t itf_desc[] = {
+      TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 5, EP_OUT, EP_IN, 64)
+    };
+
+    g_executed.clear();
+    mtu_set_instance(&mtu);
+    ON_CALL(mtu, usbd_open_edpt_pair)
+      .WillByDefault(DoAll(SetArgPointee<4>(EP_OUT),
+                           SetArgPointee<5>(EP_IN),
+                           Return(true)));
+    EXPECT_CALL(mtu, usbd_edpt_xfer(_, EP_OUT, _, _))
+      .WillOnce(DoAll(SaveArg<2>(&epout), Return(true)));
+
+    cmsis_dapd_init();
+    cmsis_dapd_reset(0);
+    ASSERT_NE(0, cmsis_dapd_open(0, reinterpret_cast<tusb_desc_interface_t const*>(itf_desc), sizeof(itf_desc)));
+    ASSERT_NE(nullptr, epout);
+  }
+
+  void TearDown() override
+  {
+    mtu_set_instance(nullptr);
+  }
+
+  // Emulate reception of a request packet.
+  void receive(uint8_t id, uint8_t arg = 1)
+  {
+    epout[0] = id;
+    epout[1] = arg;
+    cmsis_dapd_xfer_cb(0, EP_OUT, XFER_RESULT_SUCCESS, 2);
+  }
+
+  // Emulate reception of a batch with one command.
+  void receive_batch(uint8_t id, uint8_t cmd, uint8_t arg = 1)
+  {
+    epout[0] = id;
+    epout[1] = 1;
+    epout[2] = cmd;
+    epout[3] = arg;
+    cmsis_dapd_xfer_cb(0, EP_OUT, XFER_RESULT_SUCCESS, 4);
+  }
+
+  // Emulate completion of a response transfer.
+  void transmitted(void)
+  {
+    cmsis_dapd_xfer_cb(0, EP_IN, XFER_RESULT_SUCCESS, 2);
+  }
+
+  NiceMock<MockTinyUsb> mtu;
+  uint8_t *epout = nullptr;
+};
+
+} // namespace
+
+TEST_F(DapExecutor, no_request)
+{
+  EXPECT_EQ(0u, dap_execute_requests(DAP_PACKET_COUNT));
+}
+
+TEST_F(DapExecutor, drains_all_ready_requests)
+{
+  receive(ID_DAP_Info);
+  receive(ID_DAP_Transfer);
+  receive(ID_DAP_TransferBlock);
+  EXPECT_EQ(3u, dap_execute_requests(DAP_PACKET_COUNT));
+  EXPECT_EQ(0u, dap_execute_requests(DAP_PACKET_COUNT));
+  EXPECT_EQ(3u, g_executed.size());
+}
+
+TEST_F(DapExecutor, packets_per_loop_follow_budget)
+{
+  for (unsigned i = 0; i < DAP_PACKET_COUNT; ++i) {
+    receive(ID_DAP_Transfer);
+  }
+  std::vector<uint32_t> per_loop;
+  for (unsigned loop = 0; loop < 4; ++loop) {
+    per_loop.push_back(dap_execute_requests(3));
+  }
+  EXPECT_EQ((std::vector<uint32_t>{3, DAP_PACKET_COUNT - 3, 0, 0}), per_loop);
+}
+
+TEST_F(DapExecutor, stops_when_response_ring_is_full)
+{
+  for (unsigned i = 0; i < DAP_PACKET_COUNT; ++i) {
+    receive(ID_DAP_Transfer);
+  }
+  EXPECT_EQ((uint32_t)DAP_PACKET_COUNT, dap_execute_requests(DAP_PACKET_COUNT));
+  receive(ID_DAP_Transfer);
+  receive(ID_DAP_Transfer);
+  EXPECT_EQ(0u, dap_execute_requests(DAP_PACKET_COUNT));
+  transmitted();
+  EXPECT_EQ(1u, dap_execute_requests(DAP_PACKET_COUNT));
+  transmitted();
+  EXPECT_EQ(1u, dap_execute_requests(DAP_PACKET_COUNT));
+}
+
+TEST_F(DapExecutor, waits_for_end_of_queued_commands)
+{
+  receive_batch(ID_DAP_QueueCommands, ID_DAP_Transfer);
+  receive_batch(ID_DAP_QueueCommands, ID_DAP_TransferBlock);
+  EXPECT_EQ(0u, dap_execute_requests(DAP_PACKET_COUNT));
+  receive_batch(ID_DAP_ExecuteCommands, ID_DAP_Info);
+  EXPECT_EQ(3u, dap_execute_requests(DAP_PACKET_COUNT));
+  EXPECT_EQ((std::vector<uint8_t>{ID_DAP_Transfer, ID_DAP_TransferBlock, ID_DAP_Info}), g_executed);
+}
+
+TEST_F(DapExecutor, packet_size_info_reports_link_size)
+{
+  uint8_t *epin = nullptr;
+  ON_CALL(mtu, usbd_edpt_claim(_, EP_IN)).WillByDefault(Return(true));
+  EXPECT_CALL(mtu, usbd_edpt_xfer(_, EP_IN, _, 4))
+    .WillOnce(DoAll(SaveArg<2>(&epin), Return(true)));
+
+  receive(ID_DAP_Info, DAP_ID_PACKET_SIZE);
+  EXPECT_EQ(1u, dap_execute_requests(DAP_PACKET_COUNT));
+  ASSERT_NE(nullptr, epin);
+  EXPECT_EQ(ID_DAP_Info, epin[0]);
+  EXPECT_EQ(2u, epin[1]);
+  EXPECT_EQ(64u, (uint32_t)(epin[2] | (epin[3] << 8)));
+}
+
+TEST_F(DapExecutor, packet_size_info_in_batch_reports_link_size)
+{
+  uint8_t *epin = nullptr;
+  ON_CALL(mtu, usbd_edpt_claim(_, EP_IN)).WillByDefault(Return(true));
+  EXPECT_CALL(mtu, usbd_edpt_xfer(_, EP_IN, _, 6))
+    .WillOnce(DoAll(SaveArg<2>(&epin), Return(true)))
+    .WillRepeatedly(Return(true));
+
+  // A queued batch is rewritten to ExecuteCommands and must agree as well
+  receive_batch(ID_DAP_QueueCommands, ID_DAP_Info, DAP_ID_PACKET_SIZE);
+  receive(ID_DAP_Transfer);
+  EXPECT_EQ(2u, dap_execute_requests(DAP_PACKET_COUNT));
+  ASSERT_NE(nullptr, epin);
+  EXPECT_EQ(ID_DAP_ExecuteCommands, epin[0]);
+  EXPECT_EQ(1u, epin[1]);
+  EXPECT_EQ(ID_DAP_Info, epin[2]);
+  EXPECT_EQ(2u, epin[3]);
+  EXPECT_EQ(64u, (uint32_t)(epin[4] | (epin[5] << 8)));
+}
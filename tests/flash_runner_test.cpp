@@ -0,0 +1,266 @@
+#include <map>
+#include <vector>
+#include "gtest/gtest.h"
+#include "flash_runner.h"
+
+namespace {
+
+const uint32_t BKPT   = 0x20000000;
+const uint32_t SB     = 0x20000400;
+const uint32_t SP     = 0x20001000;
+const uint32_t INIT   = 0x20000021;
+const uint32_t UNINIT = 0x20000041;
+const uint32_t ERASE  = 0x20000061;
+const uint32_t PROG   = 0x20000081;
+const uint32_t BUF0   = 0x20002000;
+const uint32_t BUF1   = 0x20003000;
+const uint32_t PAGE   = 256;
+
+// Cortex-M core running a flash algorithm.
+// A call returns after a number of halt polls.
+struct Target {
+  struct Call {
+    uint32_t pc;
+    uint32_t r[3];
+    uint32_t r9, sp, lr, xpsr;
+    std::vector<uint8_t> data; // page buffer contents for ProgramPage
+  };
+  std::map<uint32_t, uint8_t> mem;
+  uint32_t regs[17] = {};
+  bool     running = false;
+  unsigned polls_left = 0;
+  unsigned call_polls = 3;       // polls until a call returns
+  std::map<uint32_t, uint32_t> results; // pc -> R0
+  std::vector<Call> calls;
+  uint32_t running_buffer = 0;   // buffer used by the running ProgramPage
+  bool     wrote_running_buffer = false;
+  bool     wrote_while_running  = false;
+  uint32_t now = 0;
+  bool     hang = false;
+
+  static Target* self(void* ctx) { return static_cast<Target*>(ctx); }
+
+  static bool write_mem(void* ctx, uint32_t addr, const uint8_t* data, uint32_t len)
+  {
+    Target* t = self(ctx);
+    if (t->running) {
+      t->wrote_while_running = true;
+      if ((addr < t->running_buffer + PAGE) && (addr + len > t->running_buffer)) t->wrote_running_buffer = true;
+    }
+    for (uint32_t i = 0; i < len; ++i) t->mem[addr + i] = data[i];
+    return true;
+  }
+  static bool write_reg(void* ctx, uint32_t reg, uint32_t value)
+  {
+    Target* t = self(ctx);
+    EXPECT_FALSE(t->running);
+    t->regs[reg] = value;
+    return true;
+  }
+  static bool read_reg(void* ctx, uint32_t reg, uint32_t* value)
+  {
+    *value = self(ctx)->regs[reg];
+    return true;
+  }
+  static bool resume(void* ctx)
+  {
+    Target* t = self(ctx);
+    Call c = {};
+    c.pc = t->regs[FLASH_REG_PC];
+    for (int i = 0; i < 3; ++i) c.r[i] = t->regs[i];
+    c.r9 = t->regs[FLASH_REG_R9];
+    c.sp = t->regs[FLASH_REG_SP];
+    c.lr = t->regs[FLASH_REG_LR];
+    c.xpsr = t->regs[FLASH_REG_XPSR];
+    if (c.pc == (PROG & ~1U)) {
+      for (uint32_t i = 0; i < c.r[1]; ++i) c.data.push_back(t->mem[c.r[2] + i]);
+      t->running_buffer = c.r[2];
+    }
+    t->calls.push_back(c);
+    t->running = true;
+    t->polls_left = t->call_polls;
+    return true;
+  }
+  static bool halted(void* ctx, bool* halted)
+  {
+    Target* t = self(ctx);
+    t->now++;
+    if (t->running && !t->hang && (t->polls_left-- == 0)) {
+      t->running = false;
+      t->running_buffer = 0;
+      t->regs[0] = t->results[t->calls.back().pc | 1U];
+    }
+    *halted = !t->running;
+    return true;
+  }
+  static uint32_t millis(void* ctx) { return self(ctx)->now; }
+};
+
+class FlashRunner : public ::testing::Test {
+protected:
+  FlashRunner()
+  {
+    target = {&sim, Target::write_mem, Target::write_reg, Target::read_reg,
+              Target::resume, Target::halted, Target::millis};
+    algo = {BKPT, SB, SP, INIT, UNINIT, ERASE, PROG, {BUF0, BUF1}, PAGE, 100};
+  }
+
+  void ready(void)
+  {
+    ASSERT_EQ(FLASH_RUNNER_OK, flash_runner_setup(&runner, &target, &algo));
+    ASSERT_EQ(FLASH_RUNNER_OK, flash_runner_init(&runner, 0x08000000, 12000000, 2));
+  }
+
+  static std::vector<uint8_t> pattern(size_t len, uint8_t seed)
+  {
+    std::vector<uint8_t> v(len);
+    for (size_t i = 0; i < len; ++i) v[i] = (uint8_t)(seed + i * 7);
+    return v;
+  }
+
+  // Write in packets as the vendor command would receive them
+  uint32_t stream(uint32_t addr, const std::vector<uint8_t>& data, size_t chunk)
+  {
+    for (size_t i = 0; i < data.size(); i += chunk) {
+      size_t n = std::min(chunk, data.size() - i);
+      uint32_t status = flash_runner_write(&runner, addr + (uint32_t)i, &data[i], (uint32_t)n);
+      if (status != FLASH_RUNNER_OK) return status;
+    }
+    return FLASH_RUNNER_OK;
+  }
+
+  std::vector<Target::Call> programs(void)
+  {
+    std::vector<Target::Call> v;
+    for (const Target::Call& c : sim.calls) {
+      if (c.pc == (PROG & ~1U)) v.push_back(c);
+    }
+    return v;
+  }
+
+  Target sim;
+  flash_target_t target;
+  flash_algo_t algo;
+  flash_runner_t runner = {};
+};
+
+} // namespace
+
+TEST_F(FlashRunner, init_follows_the_calling_convention)
+{
+  ready();
+  ASSERT_EQ(1u, sim.calls.size());
+  const Target::Call& c = sim.calls[0];
+  EXPECT_EQ(INIT & ~1U, c.pc);
+  EXPECT_EQ(0x08000000u, c.r[0]);
+  EXPECT_EQ(12000000u, c.r[1]);
+  EXPECT_EQ(2u, c.r[2]);
+  EXPECT_EQ(SB, c.r9);
+  EXPECT_EQ(SP, c.sp);
+  EXPECT_EQ(BKPT | 1U, c.lr);
+  EXPECT_EQ(1UL << 24, c.xpsr);
+}
+
+TEST_F(FlashRunner, write_before_init_is_rejected)
+{
+  uint8_t b = 0;
+  EXPECT_EQ(FLASH_RUNNER_ERR_STATE, flash_runner_write(&runner, 0, &b, 1));
+  ASSERT_EQ(FLASH_RUNNER_OK, flash_runner_setup(&runner, &target, &algo));
+  EXPECT_EQ(FLASH_RUNNER_ERR_STATE, flash_runner_write(&runner, 0, &b, 1));
+}
+
+TEST_F(FlashRunner, pages_are_programmed_from_alternate_buffers)
+{
+  ready();
+  std::vector<uint8_t> data = pattern(3 * PAGE, 1);
+  ASSERT_EQ(FLASH_RUNNER_OK, stream(0x08000000, data, 60));
+  ASSERT_EQ(FLASH_RUNNER_OK, flash_runner_flush(&runner));
+
+  std::vector<Target::Call> p = programs();
+  ASSERT_EQ(3u, p.size());
+  for (size_t i = 0; i < p.size(); ++i) {
+    EXPECT_EQ(0x08000000u + i * PAGE, p[i].r[0]);
+    EXPECT_EQ(PAGE, p[i].r[1]);
+    EXPECT_EQ((i & 1) ? BUF1 : BUF0, p[i].r[2]);
+    EXPECT_EQ(std::vector<uint8_t>(data.begin() + i * PAGE, data.begin() + (i + 1) * PAGE), p[i].data);
+  }
+  EXPECT_FALSE(sim.running);
+}
+
+TEST_F(FlashRunner, next_page_streams_while_programming)
+{
+  ready();
+  ASSERT_EQ(FLASH_RUNNER_OK, stream(0x08000000, pattern(4 * PAGE, 3), 60));
+  EXPECT_TRUE(sim.wrote_while_running);
+  EXPECT_FALSE(sim.wrote_running_buffer);
+  ASSERT_EQ(FLASH_RUNNER_OK, flash_runner_flush(&runner));
+  EXPECT_EQ(4u, programs().size());
+}
+
+TEST_F(FlashRunner, partial_page_is_programmed_on_flush)
+{
+  ready();
+  std::vector<uint8_t> data = pattern(PAGE + 10, 5);
+  ASSERT_EQ(FLASH_RUNNER_OK, stream(0x08000000, data, 64));
+  EXPECT_EQ(1u, programs().size());
+  ASSERT_EQ(FLASH_RUNNER_OK, flash_runner_flush(&runner));
+  std::vector<Target::Call> p = programs();
+  ASSERT_EQ(2u, p.size());
+  EXPECT_EQ(0x08000000u + PAGE, p[1].r[0]);
+  EXPECT_EQ(10u, p[1].r[1]);
+}
+
+TEST_F(FlashRunner, gap_starts_a_new_page)
+{
+  ready();
+  std::vector<uint8_t> data = pattern(16, 9);
+  ASSERT_EQ(FLASH_RUNNER_OK, stream(0x08000000, data, 16));
+  ASSERT_EQ(FLASH_RUNNER_OK, stream(0x08001000, data, 16));
+  ASSERT_EQ(FLASH_RUNNER_OK, flash_runner_flush(&runner));
+  std::vector<Target::Call> p = programs();
+  ASSERT_EQ(2u, p.size());
+  EXPECT_EQ(0x08000000u, p[0].r[0]);
+  EXPECT_EQ(0x08001000u, p[1].r[0]);
+  EXPECT_EQ(16u, p[1].r[1]);
+}
+
+TEST_F(FlashRunner, erase_waits_for_programming)
+{
+  ready();
+  ASSERT_EQ(FLASH_RUNNER_OK, stream(0x08000000, pattern(PAGE, 0), PAGE));
+  EXPECT_TRUE(sim.running);
+  ASSERT_EQ(FLASH_RUNNER_OK, flash_runner_erase(&runner, 0x08004000));
+  ASSERT_EQ(3u, sim.calls.size());
+  EXPECT_EQ(ERASE & ~1U, sim.calls[2].pc);
+  EXPECT_EQ(0x08004000u, sim.calls[2].r[0]);
+}
+
+TEST_F(FlashRunner, algorithm_error_is_reported)
+{
+  ready();
+  sim.results[PROG] = 1;
+  ASSERT_EQ(FLASH_RUNNER_OK, stream(0x08000000, pattern(PAGE, 0), PAGE));
+  EXPECT_EQ(FLASH_RUNNER_ERR_ALGO, flash_runner_flush(&runner));
+  EXPECT_EQ(1u, runner.result);
+  // Init is needed again
+  uint8_t b = 0;
+  EXPECT_EQ(FLASH_RUNNER_ERR_STATE, flash_runner_write(&runner, 0, &b, 1));
+}
+
+TEST_F(FlashRunner, hung_algorithm_times_out)
+{
+  ready();
+  sim.hang = true;
+  EXPECT_EQ(FLASH_RUNNER_ERR_TIMEOUT, flash_runner_erase(&runner, 0x08000000));
+}
+
+TEST_F(FlashRunner, uninit_programs_pending_data)
+{
+  ready();
+  ASSERT_EQ(FLASH_RUNNER_OK, stream(0x08000000, pattern(20, 0), 20));
+  ASSERT_EQ(FLASH_RUNNER_OK, flash_runner_uninit(&runner, 2));
+  ASSERT_EQ(3u, sim.calls.size());
+  EXPECT_EQ(PROG & ~1U, sim.calls[1].pc);
+  EXPECT_EQ(UNINIT & ~1U, sim.calls[2].pc);
+  EXPECT_EQ(2u, sim.calls[2].r[0]);
+}
@@ -0,0 +1,138 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "itm_filter.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+namespace {
+
+const Bytes SYNC      = {0x00, 0x00, 0x00, 0x00, 0x00, 0x80};
+const Bytes OVERFLOW  = {0x70};
+const Bytes PORT0_U8  = {0x01, 'A'};
+const Bytes PORT1_U16 = {0x0A, 0x34, 0x12};
+const Bytes PORT31_U32 = {0xFB, 0x78, 0x56, 0x34, 0x12};
+const Bytes LTS1      = {0xC0, 0x85, 0x01};  // local timestamp format 1
+const Bytes LTS2      = {0x30};              // local timestamp format 2
+const Bytes GTS1      = {0x94, 0x81, 0x82, 0x83, 0x04};
+const Bytes DWT_PC    = {0x17, 0x00, 0x10, 0x00, 0x08};  // periodic PC sample
+const Bytes PAGE1     = {0x18};              // stimulus port page 1
+const Bytes PAGE0     = {0x08};
+
+Bytes cat(std::initializer_list<Bytes> parts)
+{
+  Bytes v;
+  for (const Bytes& p : parts) v.insert(v.end(), p.begin(), p.end());
+  return v;
+}
+
+class ItmFilter : public ::testing::Test {
+protected:
+  Bytes run(Bytes data)
+  {
+    data.resize(itm_filter_run(&filter, data.data(), (uint32_t)data.size()));
+    return data;
+  }
+
+  itm_filter_t filter;
+};
+
+} // namespace
+
+TEST_F(ItmFilter, keeps_everything_by_default)
+{
+  itm_filter_init(&filter, 0xFFFFFFFFU, ITM_FILTER_ALL);
+  Bytes in = cat({SYNC, PORT0_U8, PORT1_U16, LTS1, LTS2, GTS1, DWT_PC, OVERFLOW, PORT31_U32});
+  EXPECT_EQ(in, run(in));
+  EXPECT_EQ(0u, filter.dropped);
+}
+
+TEST_F(ItmFilter, keeps_all_only_without_selection)
+{
+  itm_filter_init(&filter, 0xFFFFFFFFU, ITM_FILTER_ALL);
+  EXPECT_TRUE(itm_filter_keeps_all(&filter));
+  itm_filter_init(&filter, 0x7FFFFFFFU, ITM_FILTER_ALL);
+  EXPECT_FALSE(itm_filter_keeps_all(&filter));
+  itm_filter_init(&filter, 0xFFFFFFFFU, ITM_FILTER_ALL & ~ITM_FILTER_TIMESTAMP);
+  EXPECT_FALSE(itm_filter_keeps_all(&filter));
+}
+
+TEST_F(ItmFilter, selects_stimulus_ports)
+{
+  itm_filter_init(&filter, (1U << 1) | (1U << 31), ITM_FILTER_ALL);
+  Bytes in = cat({PORT0_U8, PORT1_U16, PORT0_U8, PORT31_U32});
+  EXPECT_EQ(cat({PORT1_U16, PORT31_U32}), run(in));
+  EXPECT_EQ(2u * PORT0_U8.size(), filter.dropped);
+}
+
+TEST_F(ItmFilter, selects_packet_types)
+{
+  itm_filter_init(&filter, 0xFFFFFFFFU, ITM_FILTER_INSTRUMENTATION);
+  Bytes in = cat({SYNC, LTS1, PORT0_U8, GTS1, DWT_PC, LTS2, PORT1_U16, OVERFLOW});
+  EXPECT_EQ(cat({PORT0_U8, PORT1_U16}), run(in));
+
+  itm_filter_init(&filter, 0U, ITM_FILTER_HARDWARE | ITM_FILTER_OVERFLOW);
+  EXPECT_EQ(cat({DWT_PC, OVERFLOW}), run(in));
+}
+
+TEST_F(ItmFilter, payload_looking_like_headers)
+{
+  itm_filter_init(&filter, 1U << 0, ITM_FILTER_INSTRUMENTATION);
+  // Payload bytes of port 1 which look like port 0 headers
+  Bytes in = cat({{0x0B, 0x01, 0x01, 0x01, 0x01}, PORT0_U8});
+  EXPECT_EQ(PORT0_U8, run(in));
+}
+
+TEST_F(ItmFilter, packets_split_across_calls)
+{
+  itm_filter_init(&filter, 1U << 31, ITM_FILTER_ALL);
+  Bytes in = cat({PORT0_U8, PORT31_U32, LTS1, PORT1_U16});
+  Bytes out;
+  for (uint8_t b : in) {
+    Bytes r = run({b});
+    out.insert(out.end(), r.begin(), r.end());
+  }
+  EXPECT_EQ(cat({PORT31_U32, LTS1}), out);
+}
+
+TEST_F(ItmFilter, stimulus_port_pages)
+{
+  itm_filter_init(&filter, 1U << 0, ITM_FILTER_INSTRUMENTATION);
+  EXPECT_EQ(cat({PORT0_U8, PORT0_U8}), run(cat({PORT0_U8, PAGE1, PORT0_U8, PAGE0, PORT0_U8})));
+
+  itm_filter_init(&filter, 0xFFFFFFFFU, ITM_FILTER_INSTRUMENTATION);
+  EXPECT_EQ(cat({PORT0_U8, PORT0_U8}), run(cat({PAGE1, PORT0_U8, PAGE0, PORT0_U8})));
+}
+
+TEST_F(ItmFilter, resyncs_after_desync)
+{
+  itm_filter_init(&filter, 0xFFFFFFFFU, ITM_FILTER_ALL);
+  itm_filter_desync(&filter);
+  Bytes in = cat({{0x34, 0x12}, PORT0_U8, SYNC, PORT1_U16});
+  EXPECT_EQ(PORT1_U16, run(in));
+  EXPECT_EQ(4u + SYNC.size(), filter.dropped);
+}
+
+TEST_F(ItmFilter, reserved_header_waits_for_sync)
+{
+  itm_filter_init(&filter, 0xFFFFFFFFU, ITM_FILTER_ALL);
+  Bytes in = cat({PORT0_U8, {0x04}, PORT0_U8, SYNC, PORT1_U16});
+  EXPECT_EQ(cat({PORT0_U8, PORT1_U16}), run(in));
+}
+
+TEST_F(ItmFilter, sync_realigns_packets)
+{
+  itm_filter_init(&filter, 0xFFFFFFFFU, ITM_FILTER_ALL & ~ITM_FILTER_SYNC);
+  // A truncated 4 byte packet: the sync packet restores alignment
+  Bytes in = cat({{0x03, 0x11}, SYNC, PORT1_U16});
+  Bytes out = run(in);
+  ASSERT_GE(out.size(), PORT1_U16.size());
+  EXPECT_EQ(PORT1_U16, Bytes(out.end() - PORT1_U16.size(), out.end()));
+}
+
+TEST_F(ItmFilter, long_continuation_is_bounded)
+{
+  itm_filter_init(&filter, 0xFFFFFFFFU, ITM_FILTER_INSTRUMENTATION);
+  // A timestamp carries 4 payload bytes at most
+  Bytes in = cat({{0xC0, 0x81, 0x82, 0x83, 0x84}, PORT0_U8});
+  EXPECT_EQ(PORT0_U8, run(in));
+}
@@ -0,0 +1,144 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "pio_sim.h"
+#include "jtag_pio.h"
+
+namespace {
+
+const unsigned TDI    = 0;
+const unsigned TDO    = 1;
+const unsigned TCK    = 2;
+const unsigned TMS    = 3;
+const unsigned OFFSET = 7;
+
+// JTAG target model: samples TMS/TDI on TCK rising edges and updates TDO
+// on falling edges.
+struct Target {
+  struct Edge {
+    uint64_t cycle;
+    unsigned tms;
+    unsigned tdi;
+    unsigned tdo;
+  };
+  std::vector<Edge>     edges;
+  std::vector<unsigned> tdo_bits; // bit presented before each rising edge
+  unsigned prev_clk = 0;
+  unsigned out = 0;
+
+  uint32_t update(uint64_t cycle, uint32_t pins, uint32_t)
+  {
+    unsigned clk = (pins >> TCK) & 1U;
+    if (clk && !prev_clk) {
+      edges.push_back({cycle, (pins >> TMS) & 1U, (pins >> TDI) & 1U, out});
+    } else if (!clk && prev_clk) {
+      out = (edges.size() < tdo_bits.size()) ? tdo_bits[edges.size()] : 0U;
+    }
+    prev_clk = clk;
+    return out << TDO;
+  }
+
+  void drive(uint32_t value, unsigned count)
+  {
+    for (unsigned i = 0; i < count; ++i) {
+      tdo_bits.push_back((value >> i) & 1U);
+    }
+    out = tdo_bits.empty() ? 0U : tdo_bits[0];
+  }
+};
+
+class JtagPio : public ::testing::Test {
+protected:
+  JtagPio() : sim(jtag_program_instructions, JTAG_PIO_PROGRAM_LENGTH, OFFSET, config())
+  {
+    const uint32_t outputs = (1U << TCK) | (1U << TMS) | (1U << TDI);
+    sim.set_pins((1U << TMS) | (1U << TDI), outputs);
+    sim.set_pindirs(outputs, outputs | (1U << TDO));
+    sim.jump(OFFSET + JTAG_PIO_OFFSET_GET_NEXT_CMD);
+    sim.set_pin_model([this](uint64_t c, uint32_t p, uint32_t d) { return target.update(c, p, d); });
+  }
+
+  static PioSim::Config config(void)
+  {
+    PioSim::Config c = {};
+    c.wrap_target  = JTAG_PIO_WRAP_TARGET;
+    c.wrap         = JTAG_PIO_WRAP;
+    c.sideset_bits = JTAG_PIO_SIDESET_BITS;
+    c.sideset_opt  = true;
+    c.sideset_base = TCK;
+    c.out_base     = TDI;
+    c.out_count    = 1;
+    c.set_base     = TMS;
+    c.set_count    = 1;
+    c.in_base      = TDO;
+    c.out_shift_right = true;
+    c.in_shift_right  = true;
+    return c;
+  }
+
+  uint32_t shift(uint32_t tms, uint32_t count, uint32_t tdi)
+  {
+    sim.put(jtag_pio_cmd(OFFSET, tms, count));
+    sim.put(tdi);
+    sim.run_until_idle();
+    EXPECT_FALSE(sim.rx_empty());
+    return jtag_pio_read_value(sim.get(), count);
+  }
+
+  uint32_t field(unsigned Target::Edge::*member, size_t first, unsigned count)
+  {
+    uint32_t v = 0;
+    for (unsigned i = 0; i < count; ++i) {
+      v |= target.edges[first + i].*member << i;
+    }
+    return v;
+  }
+
+  Target target;
+  PioSim sim;
+};
+
+} // namespace
+
+TEST_F(JtagPio, tdi_is_lsb_first)
+{
+  shift(0, 8, 0x5A);
+  ASSERT_EQ(8u, target.edges.size());
+  EXPECT_EQ(0x5Au, field(&Target::Edge::tdi, 0, 8));
+}
+
+TEST_F(JtagPio, tms_is_held_per_command)
+{
+  shift(1, 3, 0);
+  shift(0, 2, 0);
+  shift(1, 1, 0);
+  ASSERT_EQ(6u, target.edges.size());
+  EXPECT_EQ(0x27u, field(&Target::Edge::tms, 0, 6));
+}
+
+TEST_F(JtagPio, tdo_is_captured)
+{
+  target.drive(0xCAFEF00D, 32);
+  EXPECT_EQ(0xCAFEF00Du, shift(0, 32, 0));
+}
+
+TEST_F(JtagPio, short_capture_is_right_aligned)
+{
+  target.drive(0x5, 3);
+  EXPECT_EQ(0x5u, shift(0, 3, 0));
+}
+
+TEST_F(JtagPio, clock_period_is_four_cycles)
+{
+  shift(0, 16, 0x1234);
+  ASSERT_EQ(16u, target.edges.size());
+  for (size_t i = 1; i < target.edges.size(); ++i) {
+    EXPECT_EQ(JTAG_PIO_CYCLES_PER_BIT, target.edges[i].cycle - target.edges[i - 1].cycle);
+  }
+}
+
+TEST_F(JtagPio, clock_idles_low)
+{
+  shift(1, 5, 0x1F);
+  EXPECT_EQ(0u, (sim.pins() >> TCK) & 1U);
+  EXPECT_TRUE(sim.stalled());
+}
@@ -0,0 +1,307 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+#include <assert.h>
+#include <string.h>
+#include "pio_sim.h"
+
+#define FIFO_DEPTH  4U
+
+static uint32_t bit_mask(unsigned count)
+{
+  return (count >= 32U) ? 0xFFFFFFFFU : ((1U << count) - 1U);
+}
+
+static uint32_t bit_reverse(uint32_t v)
+{
+  uint32_t r = 0;
+  for (unsigned i = 0; i < 32; ++i) {
+    r = (r << 1) | (v & 1U);
+    v >>= 1;
+  }
+  return r;
+}
+
+PioSim::PioSim(const uint16_t* program, unsigned length, unsigned offset, const Config& cfg)
+  : cfg_(cfg), cycle_(0), pc_(0), delay_(0), stalled_(false),
+    x_(0), y_(0), osr_(0), isr_(0), osr_count_(32), isr_count_(0),
+    pins_(0), pindirs_(0), ext_pins_(0)
+{
+  memset(imem_, 0, sizeof(imem_));
+  for (unsigned i = 0; i < length; ++i) {
+    uint16_t instr = program[i];
+    // pio_add_program() relocates JMP targets
+    if ((instr & 0xE000U) == 0U) instr = (uint16_t)(instr + offset);
+    imem_[(offset + i) & 31U] = instr;
+  }
+  cfg_.wrap_target += offset;
+  cfg_.wrap        += offset;
+}
+
+void PioSim::set_pins(uint32_t values, uint32_t mask)
+{
+  pins_ = (pins_ & ~mask) | (values & mask);
+}
+
+void PioSim::set_pindirs(uint32_t dirs, uint32_t mask)
+{
+  pindirs_ = (pindirs_ & ~mask) | (dirs & mask);
+}
+
+uint32_t PioSim::get(void)
+{
+  assert(!rx_fifo_.empty());
+  uint32_t v = rx_fifo_.front();
+  rx_fifo_.pop_front();
+  return v;
+}
+
+uint32_t PioSim::read_pins(void)
+{
+  return (pins_ & pindirs_) | (ext_pins_ & ~pindirs_);
+}
+
+void PioSim::apply_sideset(uint32_t value)
+{
+  unsigned count = cfg_.sideset_bits - (cfg_.sideset_opt ? 1U : 0U);
+  for (unsigned i = 0; i < count; ++i) {
+    uint32_t bit = 1U << ((cfg_.sideset_base + i) & 31U);
+    uint32_t& reg = cfg_.sideset_pindirs ? pindirs_ : pins_;
+    reg = (value & (1U << i)) ? (reg | bit) : (reg & ~bit);
+  }
+}
+
+uint32_t PioSim::shift_out(unsigned count)
+{
+  uint32_t data;
+  if (cfg_.out_shift_right) {
+    data = osr_ & bit_mask(count);
+    osr_ = (count >= 32U) ? 0U : (osr_ >> count);
+  } else {
+    data = (count >= 32U) ? osr_ : (osr_ >> (32U - count));
+    osr_ = (count >= 32U) ? 0U : (osr_ << count);
+  }
+  osr_count_ = (osr_count_ + count > 32U) ? 32U : osr_count_ + count;
+  return data;
+}
+
+void PioSim::shift_in(uint32_t data, unsigned count)
+{
+  data &= bit_mask(count);
+  if (count >= 32U) {
+    isr_ = data;
+  } else if (cfg_.in_shift_right) {
+    isr_ = (isr_ >> count) | (data << (32U - count));
+  } else {
+    isr_ = (isr_ << count) | data;
+  }
+  isr_count_ = (isr_count_ + count > 32U) ? 32U : isr_count_ + count;
+}
+
+// Execute an instruction. Returns false if the state machine stalls.
+bool PioSim::execute(uint16_t instr)
+{
+  unsigned next = (pc_ == cfg_.wrap) ? cfg_.wrap_target : ((pc_ + 1U) & 31U);
+  unsigned op   = (instr >> 13) & 7U;
+  unsigned arg1 = (instr >> 5) & 7U;
+  unsigned arg2 = instr & 31U;
+  unsigned count = arg2 ? arg2 : 32U;
+
+  switch (op) {
+    case 0: { // JMP
+      bool taken;
+      switch (arg1) {
+        case 0:  taken = true; break;
+        case 1:  taken = (x_ == 0U); break;
+        case 2:  taken = (x_ != 0U); --x_; break;
+        case 3:  taken = (y_ == 0U); break;
+        case 4:  taken = (y_ != 0U); --y_; break;
+        case 5:  taken = (x_ != y_); break;
+        case 6:  taken = (read_pins() >> cfg_.jmp_pin) & 1U; break;
+        default: taken = (osr_count_ < 32U); break;
+      }
+      if (taken) next = arg2;
+      break;
+    }
+    case 1: { // WAIT
+      unsigned polarity = (instr >> 7) & 1U;
+      unsigned source   = (instr >> 5) & 3U;
+      unsigned level    = polarity;
+      if (source == 0U) {
+        level = (read_pins() >> arg2) & 1U;
+      } else if (source == 1U) {
+        level = (read_pins() >> ((cfg_.in_base + arg2) & 31U)) & 1U;
+      }
+      if (level != polarity) return false;
+      break;
+    }
+    case 2: { // IN
+      uint32_t data;
+      switch (arg1) {
+        case 0: {
+          uint32_t levels = read_pins();
+          data = cfg_.in_base ? ((levels >> cfg_.in_base) | (levels << (32U - cfg_.in_base))) : levels;
+          break;
+        }
+        case 1:  data = x_; break;
+        case 2:  data = y_; break;
+        case 6:  data = isr_; break;
+        case 7:  data = osr_; break;
+        default: data = 0U; break;
+      }
+      shift_in(data, count);
+      break;
+    }
+    case 3: { // OUT
+      uint32_t data = shift_out(count);
+      switch (arg1) {
+        case 0:
+        case 4: {
+          uint32_t& reg = (arg1 == 0) ? pins_ : pindirs_;
+          for (unsigned i = 0; (i < count) && (i < cfg_.out_count); ++i) {
+            uint32_t bit = 1U << ((cfg_.out_base + i) & 31U);
+            reg = (data & (1U << i)) ? (reg | bit) : (reg & ~bit);
+          }
+          break;
+        }
+        case 1: x_ = data; break;
+        case 2: y_ = data; break;
+        case 5: next = data & 31U; break;
+        case 6: isr_ = data; isr_count_ = count; break;
+        default: break;
+      }
+      break;
+    }
+    case 4: { // PUSH/PULL
+      bool is_pull = (instr >> 7) & 1U;
+      bool if_flag = (instr >> 6) & 1U;
+      bool block   = (instr >> 5) & 1U;
+      if (is_pull) {
+        if (if_flag && (osr_count_ < 32U)) break;
+        if (tx_fifo_.empty()) {
+          if (block) return false;
+          osr_ = x_;
+        } else {
+          osr_ = tx_fifo_.front();
+          tx_fifo_.pop_front();
+        }
+        osr_count_ = 0U;
+      } else {
+        if (if_flag && (isr_count_ < 32U)) break;
+        if (rx_fifo_.size() >= FIFO_DEPTH) {
+          if (block) return false;
+        } else {
+          rx_fifo_.push_back(isr_);
+        }
+        isr_ = 0U;
+        isr_count_ = 0U;
+      }
+      break;
+    }
+    case 5: { // MOV
+      unsigned source = arg2 & 7U;
+      unsigned mop    = (arg2 >> 3) & 3U;
+      uint32_t data;
+      switch (source) {
+        case 0:  data = read_pins(); break;
+        case 1:  data = x_; break;
+        case 2:  data = y_; break;
+        case 6:  data = isr_; break;
+        case 7:  data = osr_; break;
+        default: data = 0U; break;
+      }
+      if (mop == 1U) data = ~data;
+      if (mop == 2U) data = bit_reverse(data);
+      switch (arg1) {
+        case 0:
+          for (unsigned i = 0; i < cfg_.out_count; ++i) {
+            uint32_t bit = 1U << ((cfg_.out_base + i) & 31U);
+            pins_ = (data & (1U << i)) ? (pins_ | bit) : (pins_ & ~bit);
+          }
+          break;
+        case 1: x_ = data; break;
+        case 2: y_ = data; break;
+        case 5: next = data & 31U; break;
+        case 6: isr_ = data; isr_count_ = 0U; break;
+        case 7: osr_ = data; osr_count_ = 0U; break;
+        default: break;
+      }
+      break;
+    }
+    case 6: // IRQ is not modelled
+      break;
+    default: { // SET
+      switch (arg1) {
+        case 0:
+        case 4: {
+          uint32_t& reg = (arg1 == 0) ? pins_ : pindirs_;
+          for (unsigned i = 0; i < cfg_.set_count; ++i) {
+            uint32_t bit = 1U << ((cfg_.set_base + i) & 31U);
+            reg = (arg2 & (1U << i)) ? (reg | bit) : (reg & ~bit);
+          }
+          break;
+        }
+        case 1: x_ = arg2; break;
+        case 2: y_ = arg2; break;
+        default: break;
+      }
+      break;
+    }
+  }
+  pc_ = next;
+  return true;
+}
+
+void PioSim::step(void)
+{
+  if (pin_model_) ext_pins_ = pin_model_(cycle_, pins_, pindirs_);
+  ++cycle_;
+
+  if (delay_) {
+    --delay_;
+    return;
+  }
+
+  uint16_t instr = imem_[pc_];
+  unsigned field = (instr >> 8) & 31U;
+  unsigned delay_bits = 5U - cfg_.sideset_bits;
+  uint32_t sideset = field >> delay_bits;
+  if (cfg_.sideset_bits) {
+    if (!cfg_.sideset_opt) {
+      apply_sideset(sideset);
+    } else if (sideset & (1U << (cfg_.sideset_bits - 1U))) {
+      apply_sideset(sideset & bit_mask(cfg_.sideset_bits - 1U));
+    }
+  }
+
+  stalled_ = !execute(instr);
+  if (!stalled_) delay_ = field & bit_mask(delay_bits);
+}
+
+void PioSim::run_until_idle(uint64_t max_cycles)
+{
+  uint64_t end = cycle_ + max_cycles;
+  while (cycle_ < end) {
+    step();
+    bool at_pull = ((imem_[pc_] & 0xE080U) == 0x8080U);
+    if (stalled_ && at_pull && tx_fifo_.empty()) return;
+  }
+}
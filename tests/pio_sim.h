@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2025 Koji KITAYAMA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE. */
+#ifndef PIO_SIM_H___
+#define PIO_SIM_H___
+
+#include <stdint.h>
+#include <deque>
+#include <functional>
+
+// Cycle level model of a single RP2040 PIO state machine.
+// Only the features used by the probe programs are modelled:
+// no IRQ, no autopush/autopull, no EXEC destinations.
+class PioSim {
+public:
+  struct Config {
+    unsigned wrap_target;
+    unsigned wrap;
+    unsigned sideset_bits;  // including the opt bit
+    bool     sideset_opt;
+    bool     sideset_pindirs;
+    unsigned sideset_base;
+    unsigned out_base;
+    unsigned out_count;
+    unsigned set_base;
+    unsigned set_count;
+    unsigned in_base;
+    unsigned jmp_pin;
+    bool     out_shift_right;
+    bool     in_shift_right;
+  };
+
+  // Invoked on every cycle with the pin levels driven by the state machine.
+  // Returns the levels of the pins which are not driven by the state machine.
+  typedef std::function<uint32_t(uint64_t cycle, uint32_t pins, uint32_t pindirs)> PinModel;
+
+  PioSim(const uint16_t* program, unsigned length, unsigned offset, const Config& cfg);
+
+  void     set_pin_model(PinModel model) { pin_model_ = model; }
+  void     set_pins(uint32_t values, uint32_t mask);
+  void     set_pindirs(uint32_t dirs, uint32_t mask);
+  void     jump(unsigned addr) { pc_ = addr; }
+
+  void     put(uint32_t word) { tx_fifo_.push_back(word); }
+  bool     rx_empty(void) const { return rx_fifo_.empty(); }
+  uint32_t get(void);
+  bool     tx_empty(void) const { return tx_fifo_.empty(); }
+
+  // Execute one PIO clock cycle.
+  void     step(void);
+  // Run until the state machine stalls on an empty TX FIFO.
+  void     run_until_idle(uint64_t max_cycles = 100000);
+
+  uint64_t cycle(void) const { return cycle_; }
+  uint32_t pins(void) const { return pins_; }
+  uint32_t pindirs(void) const { return pindirs_; }
+  uint32_t x(void) const { return x_; }
+  uint32_t y(void) const { return y_; }
+  bool     stalled(void) const { return stalled_; }
+
+private:
+  uint32_t read_pins(void);
+  void     apply_sideset(uint32_t value);
+  bool     execute(uint16_t instr);
+  uint32_t shift_out(unsigned count);
+  void     shift_in(uint32_t data, unsigned count);
+
+  uint16_t imem_[32];
+  Config   cfg_;
+  PinModel pin_model_;
+  std::deque<uint32_t> tx_fifo_;
+  std::deque<uint32_t> rx_fifo_;
+
+  uint64_t cycle_;
+  unsigned pc_;
+  unsigned delay_;
+  bool     stalled_;
+  uint32_t x_, y_;
+  uint32_t osr_, isr_;
+  unsigned osr_count_; // bits shifted out of OSR
+  unsigned isr_count_; // bits shifted into ISR
+  uint32_t pins_;
+  uint32_t pindirs_;
+  uint32_t ext_pins_;
+};
+
+#endif
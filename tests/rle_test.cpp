@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <vector>
+#include "gtest/gtest.h"
+#include "rle.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+TEST(Rle, parse_literal)
+{
+  const Bytes s = {0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88};
+  rle_token_t t;
+  ASSERT_EQ(9u, rle_parse(s.data(), (uint32_t)s.size(), &t));
+  EXPECT_EQ(2u, t.count);
+  EXPECT_EQ(s.data() + 1, t.data);
+}
+
+TEST(Rle, parse_run)
+{
+  const Bytes s = {0x81, 0x00, 0xFF, 0xFF, 0xFF, 0xFF};
+  rle_token_t t;
+  ASSERT_EQ(6u, rle_parse(s.data(), (uint32_t)s.size(), &t));
+  EXPECT_EQ(257u, t.count);
+  EXPECT_EQ(0xFFFFFFFFu, t.value);
+  EXPECT_EQ(nullptr, t.data);
+}
+
+TEST(Rle, longest_tokens)
+{
+  Bytes lit(1 + RLE_LITERAL_MAX * 4, 0);
+  lit[0] = 0x7F;
+  const Bytes run = {0xFF, 0xFF, 0x78, 0x56, 0x34, 0x12};
+  rle_token_t t;
+  ASSERT_EQ((uint32_t)lit.size(), rle_parse(lit.data(), (uint32_t)lit.size(), &t));
+  EXPECT_EQ(RLE_LITERAL_MAX, t.count);
+  ASSERT_EQ(RLE_RUN_SIZE, rle_parse(run.data(), (uint32_t)run.size(), &t));
+  EXPECT_EQ(RLE_RUN_MAX, t.count);
+  EXPECT_EQ(0x12345678u, t.value);
+}
+
+TEST(Rle, truncated_token_is_rejected)
+{
+  const Bytes lit = {0x01, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77};
+  const Bytes run = {0x80, 0x00, 0xFF, 0xFF, 0xFF};
+  rle_token_t t;
+  EXPECT_EQ(0u, rle_parse(lit.data(), (uint32_t)lit.size(), &t));
+  EXPECT_EQ(0u, rle_parse(run.data(), (uint32_t)run.size(), &t));
+  EXPECT_EQ(0u, rle_parse(run.data(), 0, &t));
+}
+
+namespace {
+
+typedef std::vector<uint32_t> Words;
+
+Bytes encode(const Words& words, uint32_t size, uint32_t* taken)
+{
+  Bytes out(size + 16, 0xEE);
+  rle_encoder_t e;
+  rle_encoder_init(&e, out.data(), size);
+  for (uint32_t w : words) {
+    if (!rle_encode(&e, w)) break;
+  }
+  out.resize(rle_encoder_finish(&e));
+  *taken = e.words;
+  return out;
+}
+
+Words decode(const Bytes& s)
+{
+  Words words;
+  uint32_t pos = 0;
+  while (pos < s.size()) {
+    rle_token_t t;
+    uint32_t n = rle_parse(&s[pos], (uint32_t)(s.size() - pos), &t);
+    EXPECT_NE(0u, n);
+    if (!n) break;
+    for (uint32_t i = 0; i < t.count; ++i) {
+      if (t.data) {
+        const uint8_t* p = t.data + i * 4;
+        words.push_back(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24));
+      } else {
+        words.push_back(t.value);
+      }
+    }
+    pos += n;
+  }
+  return words;
+}
+
+Words sample(void)
+{
+  Words w;
+  for (uint32_t i = 0; i < 300; ++i) w.push_back(i * 0x9E3779B9u);
+  w.insert(w.end(), 40000, 0xFFFFFFFFu);
+  w.push_back(1);
+  w.push_back(1);
+  w.push_back(2);
+  w.insert(w.end(), 129, 0);
+  return w;
+}
+
+} // namespace
+
+TEST(Rle, round_trip)
+{
+  const Words words = sample();
+  uint32_t taken;
+  Bytes s = encode(words, 4096, &taken);
+  EXPECT_EQ(words.size(), taken);
+  EXPECT_EQ(words, decode(s));
+}
+
+TEST(Rle, blank_memory_takes_one_token_per_run_max)
+{
+  uint32_t taken;
+  Bytes s = encode(Words(RLE_RUN_MAX * 3, 0xFFFFFFFFu), 64, &taken);
+  EXPECT_EQ(RLE_RUN_MAX * 3, taken);
+  EXPECT_EQ(3 * RLE_RUN_SIZE, s.size());
+}
+
+TEST(Rle, literal_is_split_at_its_maximum)
+{
+  Words words;
+  for (uint32_t i = 0; i < RLE_LITERAL_MAX + 1; ++i) words.push_back(i);
+  uint32_t taken;
+  Bytes s = encode(words, 1024, &taken);
+  EXPECT_EQ(2 + (RLE_LITERAL_MAX + 1) * 4, s.size());
+  EXPECT_EQ(words, decode(s));
+}
+
+TEST(Rle, output_is_bounded_and_decodes_to_a_prefix)
+{
+  const Words words = sample();
+  for (uint32_t size = 1; size < 80; ++size) {
+    uint32_t taken;
+    Bytes s = encode(words, size, &taken);
+    ASSERT_LE(s.size(), size);
+    Words d = decode(s);
+    ASSERT_EQ(taken, d.size());
+    EXPECT_TRUE(std::equal(d.begin(), d.end(), words.begin()));
+  }
+}
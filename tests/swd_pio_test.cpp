@@ -0,0 +1,212 @@
+#include <map>
+#include <vector>
+#include "gtest/gtest.h"
+#include "pio_sim.h"
+#include "swd_pio.h"
+
+namespace {
+
+const unsigned SWCLK  = 2;
+const unsigned SWDIO  = 3;
+const unsigned OFFSET = 5;
+
+// SWD target model: samples SWDIO on SWCLK rising edges and drives
+// scripted bits after them.
+struct Target {
+  struct Edge {
+    uint64_t cycle;
+    bool     host_drives;
+    unsigned level;
+  };
+  std::vector<Edge>        edges;
+  std::map<size_t, unsigned> script; // rising edge index -> bit driven by target
+  unsigned prev_clk = 0;
+  unsigned out = 1;
+
+  uint32_t update(uint64_t cycle, uint32_t pins, uint32_t pindirs)
+  {
+    unsigned clk = (pins >> SWCLK) & 1U;
+    if (clk && !prev_clk) {
+      bool host = (pindirs >> SWDIO) & 1U;
+      unsigned level = host ? ((pins >> SWDIO) & 1U) : out;
+      edges.push_back({cycle, host, level});
+      auto it = script.find(edges.size());
+      out = (it != script.end()) ? it->second : 1U;
+    }
+    prev_clk = clk;
+    return out << SWDIO;
+  }
+
+  void drive(size_t first_edge, uint32_t value, unsigned count)
+  {
+    for (unsigned i = 0; i < count; ++i) {
+      script[first_edge + i] = (value >> i) & 1U;
+    }
+  }
+};
+
+class SwdPio : public ::testing::Test {
+protected:
+  SwdPio() : sim(swd_program_instructions, SWD_PIO_PROGRAM_LENGTH, OFFSET, config())
+  {
+    sim.set_pins(1U << SWDIO, (1U << SWCLK) | (1U << SWDIO));
+    sim.set_pindirs((1U << SWCLK) | (1U << SWDIO), (1U << SWCLK) | (1U << SWDIO));
+    sim.jump(OFFSET + SWD_PIO_OFFSET_GET_NEXT_CMD);
+    sim.set_pin_model([this](uint64_t c, uint32_t p, uint32_t d) { return target.update(c, p, d); });
+  }
+
+  static PioSim::Config config(void)
+  {
+    PioSim::Config c = {};
+    c.wrap_target  = SWD_PIO_WRAP_TARGET;
+    c.wrap         = SWD_PIO_WRAP;
+    c.sideset_bits = SWD_PIO_SIDESET_BITS;
+    c.sideset_opt  = true;
+    c.sideset_base = SWCLK;
+    c.out_base     = SWDIO;
+    c.out_count    = 1;
+    c.set_base     = SWDIO;
+    c.set_count    = 1;
+    c.in_base      = SWDIO;
+    c.out_shift_right = true;
+    c.in_shift_right  = true;
+    return c;
+  }
+
+  void write(uint32_t count, uint32_t data)
+  {
+    sim.put(swd_pio_cmd(OFFSET, SWD_PIO_OFFSET_WRITE_CMD, count, 1));
+    sim.put(data);
+    sim.run_until_idle();
+  }
+
+  void turnaround(uint32_t count)
+  {
+    sim.put(swd_pio_cmd(OFFSET, SWD_PIO_OFFSET_WRITE_CMD, count, 0));
+    sim.put(0);
+    sim.run_until_idle();
+  }
+
+  uint32_t read(uint32_t count)
+  {
+    sim.put(swd_pio_cmd(OFFSET, SWD_PIO_OFFSET_READ_CMD, count, 0));
+    sim.run_until_idle();
+    EXPECT_FALSE(sim.rx_empty());
+    return swd_pio_read_value(sim.get(), count);
+  }
+
+  uint32_t host_bits(size_t first_edge, unsigned count)
+  {
+    uint32_t v = 0;
+    for (unsigned i = 0; i < count; ++i) {
+      EXPECT_TRUE(target.edges[first_edge + i].host_drives) << "edge " << first_edge + i;
+      v |= target.edges[first_edge + i].level << i;
+    }
+    return v;
+  }
+
+  Target target;
+  PioSim sim;
+};
+
+} // namespace
+
+TEST_F(SwdPio, write_is_lsb_first)
+{
+  write(8, 0xA5);
+  ASSERT_EQ(8u, target.edges.size());
+  EXPECT_EQ(0xA5u, host_bits(0, 8));
+}
+
+TEST_F(SwdPio, clock_period_is_four_cycles)
+{
+  write(16, 0x1234);
+  ASSERT_EQ(16u, target.edges.size());
+  for (size_t i = 1; i < target.edges.size(); ++i) {
+    EXPECT_EQ(SWD_PIO_CYCLES_PER_BIT, target.edges[i].cycle - target.edges[i - 1].cycle);
+  }
+}
+
+TEST_F(SwdPio, clock_idles_low)
+{
+  write(4, 0xF);
+  sim.run_until_idle();
+  EXPECT_EQ(0u, (sim.pins() >> SWCLK) & 1U);
+  EXPECT_TRUE(sim.stalled());
+}
+
+TEST_F(SwdPio, write_beyond_32_bits_is_zero)
+{
+  write(40, 0xFFFFFFFF);
+  ASSERT_EQ(40u, target.edges.size());
+  EXPECT_EQ(0xFFFFFFFFu, host_bits(0, 32));
+  EXPECT_EQ(0u, host_bits(32, 8));
+}
+
+TEST_F(SwdPio, turnaround_releases_swdio)
+{
+  write(8, 0xFF);
+  turnaround(2);
+  ASSERT_EQ(10u, target.edges.size());
+  EXPECT_TRUE(target.edges[7].host_drives);
+  EXPECT_FALSE(target.edges[8].host_drives);
+  EXPECT_FALSE(target.edges[9].host_drives);
+  EXPECT_EQ(0u, (sim.pindirs() >> SWDIO) & 1U);
+}
+
+TEST_F(SwdPio, read_transfer)
+{
+  const uint32_t data = 0xDEADBEEF;
+  const uint32_t turn = 1;
+  // Request: Start, APnDP=0, RnW=1, A2=0, A3=0, Parity=1, Stop, Park
+  const uint32_t request = 0x81U | (0x2U << 1) | (1U << 5);
+
+  // ACK on edges 9..11, data on 12..43, parity on 44
+  target.drive(8 + turn, 0x1, 3);
+  target.drive(8 + turn + 3, data, 32);
+  target.drive(8 + turn + 3 + 32, __builtin_parity(data), 1);
+
+  write(8, request);
+  turnaround(turn);
+  EXPECT_EQ(1u, read(3));
+  EXPECT_EQ(data, read(32));
+  EXPECT_EQ((uint32_t)__builtin_parity(data), read(1));
+  turnaround(turn);
+  write(8, 0);
+
+  ASSERT_EQ(8u + turn + 3 + 32 + 1 + turn + 8, target.edges.size());
+  EXPECT_EQ(request, host_bits(0, 8));
+  for (size_t i = 8; i < 8 + turn + 3 + 33 + turn; ++i) {
+    EXPECT_FALSE(target.edges[i].host_drives) << "edge " << i;
+  }
+  EXPECT_TRUE(target.edges[8 + turn + 3 + 33 + turn].host_drives);
+}
+
+TEST_F(SwdPio, write_transfer)
+{
+  const uint32_t data = 0x12345678;
+  const uint32_t turn = 2;
+  const uint32_t request = 0x81U | (0x0U << 1) | (0U << 5);
+
+  target.drive(8 + turn, 0x1, 3);
+
+  write(8, request);
+  turnaround(turn);
+  EXPECT_EQ(1u, read(3));
+  turnaround(turn);
+  write(32, data);
+  write(1, __builtin_parity(data));
+
+  size_t first = 8 + turn + 3 + turn;
+  ASSERT_EQ(first + 33, target.edges.size());
+  EXPECT_EQ(data, host_bits(first, 32));
+  EXPECT_EQ((uint32_t)__builtin_parity(data), host_bits(first + 32, 1));
+}
+
+TEST_F(SwdPio, wait_ack)
+{
+  target.drive(9, 0x2, 3);
+  write(8, 0x81U | (0x2U << 1) | (1U << 5));
+  turnaround(1);
+  EXPECT_EQ(2u, read(3));
+}
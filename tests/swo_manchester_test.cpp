@@ -0,0 +1,150 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "pio_sim.h"
+#include "swo_pio.h"
+
+namespace {
+
+const unsigned SWO    = 2;
+const unsigned OFFSET = 5;
+
+// SWO line model: plays Manchester packets back at a given number of PIO
+// cycles per bit. The line idles low.
+struct Line {
+  std::vector<unsigned> levels; // one entry per PIO cycle
+  double cycles_per_bit;
+
+  explicit Line(double cpb) : cycles_per_bit(cpb) {}
+
+  void idle(unsigned bits)
+  {
+    levels.insert(levels.end(), (size_t)(bits * cycles_per_bit), 0U);
+  }
+
+  // Start bit followed by count bits of data, LSB first.
+  void packet(const std::vector<uint8_t>& data, unsigned count)
+  {
+    std::vector<unsigned> bits;
+    bits.push_back(1U);
+    for (unsigned i = 0; i < count; ++i) bits.push_back((data[i / 8U] >> (i % 8U)) & 1U);
+    // Edges follow the exact half bit time so that rate errors accumulate.
+    double start = levels.size();
+    for (size_t i = 0; i < 2U * bits.size(); ++i) {
+      size_t end = (size_t)(start + (i + 1) * cycles_per_bit / 2.0 + 0.5);
+      unsigned level = (i & 1U) ? !bits[i / 2U] : bits[i / 2U];
+      while (levels.size() < end) levels.push_back(level);
+    }
+  }
+
+  void packet(const std::vector<uint8_t>& data)
+  {
+    packet(data, (unsigned)data.size() * 8U);
+  }
+
+  uint32_t update(uint64_t cycle)
+  {
+    unsigned level = (cycle < levels.size()) ? levels[cycle] : 0U;
+    return level << SWO;
+  }
+};
+
+class SwoManchester : public ::testing::Test {
+protected:
+  SwoManchester() : sim(make_sim()), line(SWO_MANCHESTER_PIO_CYCLES_PER_BIT) {}
+
+  PioSim make_sim(void)
+  {
+    PioSim::Config c = {};
+    c.wrap_target = SWO_MANCHESTER_PIO_WRAP_TARGET;
+    c.wrap        = SWO_MANCHESTER_PIO_WRAP;
+    c.in_base     = SWO;
+    c.jmp_pin     = SWO;
+    c.in_shift_right = true;
+    PioSim s(swo_manchester_program_instructions, SWO_MANCHESTER_PIO_PROGRAM_LENGTH, OFFSET, c);
+    s.jump(OFFSET + SWO_MANCHESTER_PIO_OFFSET_START);
+    s.set_pin_model([this](uint64_t cycle, uint32_t, uint32_t) { return line.update(cycle); });
+    return s;
+  }
+
+  std::vector<uint8_t> receive(void)
+  {
+    std::vector<uint8_t> bytes;
+    while (sim.cycle() < line.levels.size() + 64U) {
+      sim.step();
+      while (!sim.rx_empty()) bytes.push_back(swo_pio_read_value(sim.get()));
+    }
+    return bytes;
+  }
+
+  PioSim sim;
+  Line line;
+};
+
+} // namespace
+
+TEST_F(SwoManchester, receives_packet)
+{
+  const std::vector<uint8_t> sent = {0x55, 0x00, 0xFF, 0x81, 0x3C};
+  line.idle(3);
+  line.packet(sent);
+  line.idle(2);
+  EXPECT_EQ(sent, receive());
+}
+
+TEST_F(SwoManchester, packets_separated_by_idle)
+{
+  line.idle(2);
+  line.packet({0x01});
+  line.idle(1);
+  line.packet({0x80, 0x7F});
+  line.idle(5);
+  line.packet({0x00});
+  line.idle(2);
+  EXPECT_EQ(std::vector<uint8_t>({0x01, 0x80, 0x7F, 0x00}), receive());
+}
+
+TEST_F(SwoManchester, partial_byte_is_dropped)
+{
+  line.idle(2);
+  line.packet({0xA5, 0x0F}, 12);
+  line.idle(2);
+  line.packet({0x42});
+  line.idle(2);
+  EXPECT_EQ(std::vector<uint8_t>({0xA5, 0x42}), receive());
+}
+
+TEST_F(SwoManchester, long_packet)
+{
+  std::vector<uint8_t> sent;
+  for (unsigned i = 0; i < 64; ++i) sent.push_back((uint8_t)(i * 37));
+  line.idle(2);
+  line.packet(sent);
+  line.idle(2);
+  EXPECT_EQ(sent, receive());
+}
+
+TEST_F(SwoManchester, tolerates_rate_mismatch)
+{
+  for (double cpb : {SWO_MANCHESTER_PIO_CYCLES_PER_BIT * 0.90, SWO_MANCHESTER_PIO_CYCLES_PER_BIT * 1.10}) {
+    line = Line(cpb);
+    sim = make_sim();
+
+    std::vector<uint8_t> sent;
+    for (unsigned i = 0; i < 16; ++i) sent.push_back((uint8_t)(0xA5 ^ i));
+    line.idle(2);
+    line.packet(sent);
+    line.idle(2);
+    EXPECT_EQ(sent, receive()) << "cycles per bit " << cpb;
+  }
+}
+
+TEST(SwoManchesterClock, divider_gives_exact_rate)
+{
+  const uint32_t sys = 125000000U;
+  uint32_t div = swo_pio_clkdiv(sys, 5000000U, SWO_MANCHESTER_PIO_CYCLES_PER_BIT);
+  EXPECT_EQ(400u, div);
+  EXPECT_EQ(5000000u, swo_pio_baudrate(sys, div, SWO_MANCHESTER_PIO_CYCLES_PER_BIT));
+
+  EXPECT_EQ(256u, swo_pio_clkdiv(sys, sys / SWO_MANCHESTER_PIO_CYCLES_PER_BIT, SWO_MANCHESTER_PIO_CYCLES_PER_BIT));
+  EXPECT_EQ(0u, swo_pio_clkdiv(sys, sys / SWO_MANCHESTER_PIO_CYCLES_PER_BIT + 1U, SWO_MANCHESTER_PIO_CYCLES_PER_BIT));
+}
@@ -0,0 +1,145 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "pio_sim.h"
+#include "swo_pio.h"
+
+namespace {
+
+const unsigned SWO    = 1;
+const unsigned OFFSET = 9;
+
+// SWO line model: plays UART frames back at a given number of PIO cycles
+// per bit. The line idles high.
+struct Line {
+  std::vector<unsigned> levels; // one entry per PIO cycle
+  double cycles_per_bit;
+
+  explicit Line(double cpb) : cycles_per_bit(cpb) {}
+
+  void idle(unsigned bits)
+  {
+    levels.insert(levels.end(), (size_t)(bits * cycles_per_bit), 1U);
+  }
+
+  void frame(uint8_t value)
+  {
+    unsigned bits[10];
+    bits[0] = 0U;
+    for (unsigned i = 0; i < 8; ++i) bits[1 + i] = (value >> i) & 1U;
+    bits[9] = 1U;
+    // Bit edges follow the exact bit time so that rate errors accumulate.
+    double start = levels.size();
+    for (unsigned i = 0; i < 10; ++i) {
+      size_t end = (size_t)(start + (i + 1) * cycles_per_bit + 0.5);
+      while (levels.size() < end) levels.push_back(bits[i]);
+    }
+  }
+
+  uint32_t update(uint64_t cycle)
+  {
+    unsigned level = (cycle < levels.size()) ? levels[cycle] : 1U;
+    return level << SWO;
+  }
+};
+
+class SwoPio : public ::testing::Test {
+protected:
+  SwoPio() : sim(swo_program_instructions, SWO_PIO_PROGRAM_LENGTH, OFFSET, config()), line(SWO_PIO_CYCLES_PER_BIT)
+  {
+    sim.jump(OFFSET + SWO_PIO_OFFSET_START);
+    sim.set_pin_model([this](uint64_t c, uint32_t, uint32_t) { return line.update(c); });
+  }
+
+  static PioSim::Config config(void)
+  {
+    PioSim::Config c = {};
+    c.wrap_target = SWO_PIO_WRAP_TARGET;
+    c.wrap        = SWO_PIO_WRAP;
+    c.in_base     = SWO;
+    c.in_shift_right = true;
+    return c;
+  }
+
+  std::vector<uint8_t> receive(void)
+  {
+    std::vector<uint8_t> bytes;
+    while (sim.cycle() < line.levels.size() + 32U) {
+      sim.step();
+      while (!sim.rx_empty()) bytes.push_back(swo_pio_read_value(sim.get()));
+    }
+    return bytes;
+  }
+
+  PioSim sim;
+  Line line;
+};
+
+} // namespace
+
+TEST_F(SwoPio, receives_bytes)
+{
+  const std::vector<uint8_t> sent = {0x55, 0x00, 0xFF, 0x81, 0x3C};
+  line.idle(3);
+  for (uint8_t b : sent) {
+    line.frame(b);
+    line.idle(1);
+  }
+  EXPECT_EQ(sent, receive());
+}
+
+TEST_F(SwoPio, back_to_back_frames)
+{
+  std::vector<uint8_t> sent;
+  line.idle(2);
+  for (unsigned i = 0; i < 64; ++i) {
+    sent.push_back((uint8_t)(i * 37));
+    line.frame(sent.back());
+  }
+  EXPECT_EQ(sent, receive());
+}
+
+TEST_F(SwoPio, tolerates_rate_mismatch)
+{
+  for (double cpb : {SWO_PIO_CYCLES_PER_BIT * 0.97, SWO_PIO_CYCLES_PER_BIT * 1.03}) {
+    line = Line(cpb);
+    sim = PioSim(swo_program_instructions, SWO_PIO_PROGRAM_LENGTH, OFFSET, config());
+    sim.jump(OFFSET + SWO_PIO_OFFSET_START);
+    sim.set_pin_model([this](uint64_t c, uint32_t, uint32_t) { return line.update(c); });
+
+    std::vector<uint8_t> sent;
+    line.idle(2);
+    for (unsigned i = 0; i < 16; ++i) {
+      sent.push_back((uint8_t)(0xA5 ^ i));
+      line.frame(sent.back());
+    }
+    EXPECT_EQ(sent, receive()) << "cycles per bit " << cpb;
+  }
+}
+
+TEST_F(SwoPio, break_is_one_byte)
+{
+  line.idle(2);
+  line.levels.insert(line.levels.end(), 40 * SWO_PIO_CYCLES_PER_BIT, 0U);
+  line.idle(2);
+  line.frame(0x42);
+  EXPECT_EQ(std::vector<uint8_t>({0x00, 0x42}), receive());
+}
+
+TEST(SwoPioClock, divider_gives_exact_rate)
+{
+  const uint32_t sys = 125000000U;
+  uint32_t div = swo_pio_clkdiv(sys, 10000000U, SWO_PIO_CYCLES_PER_BIT);
+  EXPECT_EQ(400u, div); // 1.5625 in 1/256 steps
+  EXPECT_EQ(10000000u, swo_pio_baudrate(sys, div, SWO_PIO_CYCLES_PER_BIT));
+
+  div = swo_pio_clkdiv(sys, 2000000U, SWO_PIO_CYCLES_PER_BIT);
+  EXPECT_EQ(2000000u, swo_pio_baudrate(sys, div, SWO_PIO_CYCLES_PER_BIT));
+
+  div = swo_pio_clkdiv(sys, 3000000U, SWO_PIO_CYCLES_PER_BIT);
+  EXPECT_EQ(1333u, div);
+  EXPECT_EQ(3000750u, swo_pio_baudrate(sys, div, SWO_PIO_CYCLES_PER_BIT));
+
+  EXPECT_EQ(256u, swo_pio_clkdiv(sys, sys / SWO_PIO_CYCLES_PER_BIT, SWO_PIO_CYCLES_PER_BIT));
+  EXPECT_EQ(0u, swo_pio_clkdiv(sys, sys / SWO_PIO_CYCLES_PER_BIT + 1U, SWO_PIO_CYCLES_PER_BIT));
+  EXPECT_EQ(0u, swo_pio_clkdiv(sys, 0U, SWO_PIO_CYCLES_PER_BIT));
+}
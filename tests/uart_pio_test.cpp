@@ -0,0 +1,116 @@
+#include <vector>
+#include "gtest/gtest.h"
+#include "pio_sim.h"
+#include "uart_pio.h"
+
+namespace {
+
+const unsigned TX     = 4;
+const unsigned OFFSET = 20;
+
+class UartTxPio : public ::testing::Test {
+protected:
+  UartTxPio() : sim(uart_tx_program_instructions, UART_PIO_TX_PROGRAM_LENGTH, OFFSET, config())
+  {
+    sim.set_pins(1U << TX, 1U << TX);
+    sim.set_pindirs(1U << TX, 1U << TX);
+    sim.jump(OFFSET + UART_PIO_TX_WRAP_TARGET);
+  }
+
+  static PioSim::Config config(void)
+  {
+    PioSim::Config c = {};
+    c.wrap_target  = UART_PIO_TX_WRAP_TARGET;
+    c.wrap         = UART_PIO_TX_WRAP;
+    c.sideset_bits = UART_PIO_TX_SIDESET_BITS;
+    c.sideset_opt  = true;
+    c.sideset_base = TX;
+    c.out_base     = TX;
+    c.out_count    = 1;
+    c.out_shift_right = true;
+    return c;
+  }
+
+  // Record the TX level for cycles PIO cycles.
+  std::vector<unsigned> trace(unsigned cycles)
+  {
+    std::vector<unsigned> levels;
+    for (unsigned i = 0; i < cycles; ++i) {
+      sim.step();
+      levels.push_back((sim.pins() >> TX) & 1U);
+    }
+    return levels;
+  }
+
+  // Decode 8N1 frames sampled in the middle of each bit.
+  static std::vector<uint8_t> decode(const std::vector<unsigned>& levels, bool* framing_error)
+  {
+    std::vector<uint8_t> bytes;
+    const size_t cpb = UART_PIO_CYCLES_PER_BIT;
+    size_t i = 0;
+    *framing_error = false;
+    while (i < levels.size()) {
+      if (levels[i]) { ++i; continue; }
+      if (i + 10 * cpb > levels.size()) break;
+      uint8_t v = 0;
+      for (unsigned b = 0; b < 8; ++b) {
+        v |= levels[i + (1 + b) * cpb + cpb / 2] << b;
+      }
+      if (!levels[i + 9 * cpb + cpb / 2]) *framing_error = true;
+      bytes.push_back(v);
+      i += 9 * cpb + cpb / 2;
+    }
+    return bytes;
+  }
+
+  PioSim sim;
+};
+
+} // namespace
+
+TEST_F(UartTxPio, idles_high)
+{
+  std::vector<unsigned> levels = trace(100);
+  for (unsigned l : levels) EXPECT_EQ(1u, l);
+  EXPECT_TRUE(sim.stalled());
+}
+
+TEST_F(UartTxPio, sends_8n1_lsb_first)
+{
+  bool framing_error;
+  sim.put(0x5A);
+  sim.put(0x81);
+  std::vector<uint8_t> bytes = decode(trace(400), &framing_error);
+  ASSERT_EQ(2u, bytes.size());
+  EXPECT_EQ(0x5Au, bytes[0]);
+  EXPECT_EQ(0x81u, bytes[1]);
+  EXPECT_FALSE(framing_error);
+}
+
+TEST_F(UartTxPio, frames_are_back_to_back)
+{
+  sim.put(0x00);
+  sim.put(0x00);
+  std::vector<unsigned> levels = trace(300);
+  // Start bits of consecutive frames are 10 bit times apart
+  std::vector<size_t> starts;
+  for (size_t i = 1; i < levels.size(); ++i) {
+    if (levels[i - 1] && !levels[i]) starts.push_back(i);
+  }
+  ASSERT_EQ(2u, starts.size());
+  EXPECT_EQ(10u * UART_PIO_CYCLES_PER_BIT, starts[1] - starts[0]);
+}
+
+TEST_F(UartTxPio, bit_period_is_eight_cycles)
+{
+  sim.put(0x55); // alternating bits after the start bit
+  std::vector<unsigned> levels = trace(120);
+  std::vector<size_t> edges;
+  for (size_t i = 1; i < levels.size(); ++i) {
+    if (levels[i] != levels[i - 1]) edges.push_back(i);
+  }
+  ASSERT_GE(edges.size(), 9u);
+  for (size_t i = 1; i < 9; ++i) {
+    EXPECT_EQ(UART_PIO_CYCLES_PER_BIT, edges[i] - edges[i - 1]);
+  }
+}